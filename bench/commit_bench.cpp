@@ -0,0 +1,62 @@
+// Throughput of scripted bulk status changes under different commit modes.
+// Compares the old behaviour (rollback journal, synchronous=FULL, one
+// transaction per write) with WAL and with WAL plus group commit.
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "../database.cpp"
+
+using namespace std;
+
+static double updatesPerSecond(const char* path, const DatabaseOptions& options, int questions, int updates) {
+    remove(path);
+    string wal = string(path) + "-wal";
+    string shm = string(path) + "-shm";
+    remove(wal.c_str());
+    remove(shm.c_str());
+
+    Database db(path, options);
+    for (int number = 1; number <= questions; ++number) {
+        db.addQuestion(number, "Question " + to_string(number), Status::NotUnderstood);
+    }
+    db.flush();
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < updates; ++i) {
+        db.updateQuestionInDB(i % questions + 1, static_cast<Status>(i % STATUS_COUNT));
+    }
+    db.flush();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return updates / seconds;
+}
+
+int main(int argc, char** argv) {
+    const char* path = argc > 1 ? argv[1] : "commit_bench.db";
+    const int questions = 1000;
+    const int updates = 2000;
+
+    DatabaseOptions legacy;
+    legacy.wal = false;
+    legacy.synchronous = "FULL";
+
+    DatabaseOptions wal;
+
+    DatabaseOptions grouped;
+    grouped.groupCommitOps = 256;
+    grouped.groupCommitWindowMs = 1000;
+
+    double legacyRate = updatesPerSecond(path, legacy, questions, updates);
+    double walRate = updatesPerSecond(path, wal, questions, updates);
+    double groupedRate = updatesPerSecond(path, grouped, questions, updates);
+
+    printf("%-40s %12s %8s\n", "mode", "updates/s", "speedup");
+    printf("%-40s %12.0f %8.1fx\n", "rollback journal, FULL, autocommit", legacyRate, 1.0);
+    printf("%-40s %12.0f %8.1fx\n", "WAL, NORMAL, autocommit", walRate, walRate / legacyRate);
+    printf("%-40s %12.0f %8.1fx\n", "WAL, NORMAL, group commit (256 ops)", groupedRate, groupedRate / legacyRate);
+
+    remove(path);
+    remove((string(path) + "-wal").c_str());
+    remove((string(path) + "-shm").c_str());
+    return 0;
+}
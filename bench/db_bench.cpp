@@ -0,0 +1,224 @@
+// Latency of the Database and TUI data paths as the question table grows.
+// Builds synthetic databases of 1k to 1M questions and times each operation
+// with warmup and repetitions, then prints percentiles as JSON on stdout so
+// results can be saved and compared across commits. Progress goes to stderr.
+//
+// Usage: db_bench [--dir=PATH] [--sizes=1000,10000] [--label=TEXT]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../database.cpp"
+#include "../question_cache.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+struct Plan {
+    size_t warmup;
+    size_t repetitions;
+};
+
+struct Result {
+    string operation;
+    size_t samples;
+    double meanNs;
+    double p50Ns;
+    double p90Ns;
+    double p99Ns;
+    double maxNs;
+};
+
+static double percentile(const vector<double>& sorted, double fraction) {
+    size_t rank = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[min(rank, sorted.size() - 1)];
+}
+
+// Runs op(i) warmup + repetitions times and keeps the timings of the repetitions.
+static Result measure(const string& operation, Plan plan, const function<void(size_t)>& op) {
+    for (size_t i = 0; i < plan.warmup; ++i) {
+        op(i);
+    }
+    vector<double> samples;
+    samples.reserve(plan.repetitions);
+    for (size_t i = 0; i < plan.repetitions; ++i) {
+        auto start = Clock::now();
+        op(plan.warmup + i);
+        samples.push_back(chrono::duration<double, nano>(Clock::now() - start).count());
+    }
+    sort(samples.begin(), samples.end());
+    double total = 0;
+    for (double sample : samples) {
+        total += sample;
+    }
+    return {operation, samples.size(), total / samples.size(), percentile(samples, 0.50),
+            percentile(samples, 0.90), percentile(samples, 0.99), samples.back()};
+}
+
+static void removeDatabase(const string& path) {
+    remove(path.c_str());
+    remove((path + "-wal").c_str());
+    remove((path + "-shm").c_str());
+}
+
+// Numbers 1, 3, 5, ... so lookups can hit gaps, with statuses spread evenly.
+static void populate(Database& db, size_t questions) {
+    for (size_t i = 0; i < questions; ++i) {
+        int number = static_cast<int>(i * 2 + 1);
+        db.stageImport(number, "Synthetic problem " + to_string(number) + " about arrays and graphs",
+                       static_cast<Status>(i % STATUS_COUNT), false);
+        if ((i + 1) % 50000 == 0) {
+            size_t written;
+            db.mergeImport(false, written);
+        }
+    }
+    size_t written;
+    db.mergeImport(false, written);
+}
+
+static vector<Result> benchSize(const string& dir, size_t questions) {
+    string path = dir + "/db_bench_" + to_string(questions) + ".db";
+    removeDatabase(path);
+    Database db(path);
+    populate(db, questions);
+    db.createUser("bench", "password");
+
+    mt19937 rng(42);
+    int maxNumber = static_cast<int>(questions * 2);
+    vector<int> keys(4096);
+    uniform_int_distribution<int> pick(0, static_cast<int>(questions) - 1);
+    for (int& key : keys) {
+        key = pick(rng) * 2 + 1;
+    }
+    auto key = [&](size_t i) { return keys[i % keys.size()]; };
+
+    // Full scans get fewer repetitions as the table grows
+    size_t scanRepetitions = max<size_t>(5, min<size_t>(100, 20000000 / (questions * 10)));
+    Plan point{200, 2000};
+    Plan write{50, 1000};
+    Plan scan{2, scanRepetitions};
+    Plan indexScan{10, scanRepetitions * 10}; // Status counts walk the status index
+
+    vector<Result> results;
+    // Writes use even numbers above the populated range, and delete removes
+    // exactly what add inserted, so the table size stays fixed.
+    results.push_back(measure("addQuestion", write, [&](size_t i) {
+        db.addQuestion(maxNumber + static_cast<int>(i) * 2 + 2, "Benchmark question", Status::Submitted);
+    }));
+    results.push_back(measure("deleteQuestionFromDB", write, [&](size_t i) {
+        db.deleteQuestionFromDB(maxNumber + static_cast<int>(i) * 2 + 2);
+    }));
+    results.push_back(measure("updateQuestionInDB", write, [&](size_t i) {
+        db.updateQuestionInDB(key(i), static_cast<Status>(i % STATUS_COUNT));
+    }));
+    results.push_back(measure("getQuestion", point, [&](size_t i) {
+        db.getQuestion(key(i));
+    }));
+    results.push_back(measure("countQuestions(status)", indexScan, [&](size_t i) {
+        db.countQuestions(static_cast<Status>(i % STATUS_COUNT));
+    }));
+    results.push_back(measure("nextDue(10)", point, [&](size_t) {
+        db.nextDue(10);
+    }));
+    results.push_back(measure("authenticateUser", Plan{20, 200}, [&](size_t) {
+        db.authenticateUser("bench", "password");
+    }));
+    results.push_back(measure("getQuestions", scan, [&](size_t) {
+        vector<Question> all = db.getQuestions();
+    }));
+    // TUI side: loading the question cache at startup, then lookups against it
+    results.push_back(measure("QuestionCache::refreshIfChanged(load)", scan, [&](size_t) {
+        QuestionCache cache(db);
+        cache.refreshIfChanged();
+    }));
+    QuestionCache cache(db);
+    cache.refreshIfChanged();
+    // Same startup from the snapshot written on the previous exit
+    string snapshotPath = path + ".snapshot";
+    cache.saveSnapshot(snapshotPath);
+    results.push_back(measure("QuestionCache::loadSnapshot+refreshIfChanged", scan, [&](size_t) {
+        QuestionCache snapshotCache(db);
+        snapshotCache.loadSnapshot(snapshotPath);
+        snapshotCache.refreshIfChanged();
+    }));
+    remove(snapshotPath.c_str());
+    results.push_back(measure("QuestionCache::find", Plan{1000, 100000}, [&](size_t i) {
+        cache.find(key(i));
+    }));
+    results.push_back(measure("QuestionCache::count", Plan{1000, 100000}, [&](size_t i) {
+        cache.count(static_cast<Status>(i % STATUS_COUNT));
+    }));
+    results.push_back(measure("QuestionCache::nextDue(1)", Plan{1000, 100000}, [&](size_t) {
+        cache.nextDue(1);
+    }));
+
+    removeDatabase(path);
+    return results;
+}
+
+static string jsonEscape(const string& text) {
+    string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+int main(int argc, char** argv) {
+    string dir = "/tmp";
+    string label;
+    vector<size_t> sizes = {1000, 10000, 100000, 1000000};
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.rfind("--dir=", 0) == 0) {
+            dir = arg.substr(6);
+        } else if (arg.rfind("--label=", 0) == 0) {
+            label = arg.substr(8);
+        } else if (arg.rfind("--sizes=", 0) == 0) {
+            sizes.clear();
+            const char* p = arg.c_str() + 8;
+            while (*p) {
+                char* end;
+                size_t size = strtoul(p, &end, 10);
+                if (end == p || size == 0) {
+                    fprintf(stderr, "Bad size list: %s\n", arg.c_str());
+                    return 2;
+                }
+                sizes.push_back(size);
+                p = *end == ',' ? end + 1 : end;
+            }
+        } else {
+            fprintf(stderr, "Usage: db_bench [--dir=PATH] [--sizes=1000,10000] [--label=TEXT]\n");
+            return 2;
+        }
+    }
+
+    printf("{\n  \"label\": \"%s\",\n  \"timestamp\": %lld,\n  \"sqlite\": \"%s\",\n  \"runs\": [",
+           jsonEscape(label).c_str(), static_cast<long long>(time(nullptr)), sqlite3_libversion());
+    for (size_t s = 0; s < sizes.size(); ++s) {
+        fprintf(stderr, "Benchmarking %zu questions...\n", sizes[s]);
+        vector<Result> results = benchSize(dir, sizes[s]);
+        printf("%s\n    {\"questions\": %zu, \"operations\": [", s == 0 ? "" : ",", sizes[s]);
+        for (size_t r = 0; r < results.size(); ++r) {
+            const Result& result = results[r];
+            printf("%s\n      {\"name\": \"%s\", \"samples\": %zu, \"mean_ns\": %.0f, \"p50_ns\": %.0f, "
+                   "\"p90_ns\": %.0f, \"p99_ns\": %.0f, \"max_ns\": %.0f}",
+                   r == 0 ? "" : ",", jsonEscape(result.operation).c_str(), result.samples, result.meanNs,
+                   result.p50Ns, result.p90Ns, result.p99Ns, result.maxNs);
+        }
+        printf("\n    ]}");
+        fflush(stdout);
+    }
+    printf("\n  ]\n}\n");
+    return 0;
+}
@@ -0,0 +1,131 @@
+// Micro-benchmark for tag filter queries over compressed bitmaps.
+// Builds status and tag bitmaps for 10k, 100k and 1M questions whose tags
+// range from common to rare, and reports their memory and the p50/p99 latency
+// of each query, next to a scan over per-question tag lists that answers the
+// same query without bitmaps.
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../tag_filter.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+static volatile size_t sink; // Keeps the optimizer from discarding results
+
+// Tags with the share of questions that carry them
+static const pair<const char*, double> TAGS[] = {
+    {"array", 0.30}, {"string", 0.20}, {"dp", 0.12}, {"graph", 0.08}, {"tree", 0.08},
+    {"heap", 0.03}, {"trie", 0.01}, {"segment-tree", 0.001},
+};
+
+static const char* const QUERIES[] = {
+    "dp and graph and not submitted",
+    "array or string",
+    "not submitted",
+    "(dp or graph) and under-review and not tree",
+    "segment-tree and array",
+    "heap trie",
+};
+
+static double percentile(vector<double> samples, double fraction) {
+    sort(samples.begin(), samples.end());
+    return samples[min(samples.size() - 1, static_cast<size_t>(fraction * (samples.size() - 1) + 0.5))];
+}
+
+// The same query answered row by row over a tag list per question; only
+// handles the fixed queries above.
+static size_t scan(size_t query, const vector<uint8_t>& statuses, const vector<uint16_t>& tagMasks) {
+    auto has = [&](size_t row, size_t tag) { return (tagMasks[row] >> tag) & 1; };
+    size_t count = 0;
+    for (size_t row = 0; row < statuses.size(); ++row) {
+        bool submitted = statuses[row] == 0;
+        bool match = query == 0   ? has(row, 2) && has(row, 3) && !submitted
+                     : query == 1 ? has(row, 0) || has(row, 1)
+                     : query == 2 ? !submitted
+                     : query == 3 ? (has(row, 2) || has(row, 3)) && statuses[row] == 1 && !has(row, 4)
+                     : query == 4 ? has(row, 7) && has(row, 0)
+                                  : has(row, 5) && has(row, 6);
+        count += match;
+    }
+    return count;
+}
+
+int main() {
+    const size_t sizes[] = {10000, 100000, 1000000};
+    const size_t repeats = 500;
+    mt19937 rng(42);
+    uniform_real_distribution<double> chance(0, 1);
+
+    printf("%10s %-44s %10s %10s %10s %10s %10s\n", "questions", "query", "matches", "p50 us", "p99 us",
+           "scan us", "KiB");
+    for (size_t n : sizes) {
+        // Numbers with gaps, as a real problem set has
+        array<Bitmap, STATUS_COUNT> statusBits;
+        map<string, Bitmap> tagged;
+        Bitmap all;
+        vector<uint8_t> statuses(n);
+        vector<uint16_t> tagMasks(n);
+        for (size_t row = 0; row < n; ++row) {
+            uint32_t number = static_cast<uint32_t>(row + row / 4 + 1);
+            statuses[row] = static_cast<uint8_t>(rng() % STATUS_COUNT);
+            statusBits[statuses[row]].add(number);
+            all.add(number);
+            for (size_t tag = 0; tag < size(TAGS); ++tag) {
+                if (chance(rng) < TAGS[tag].second) {
+                    tagged[TAGS[tag].first].add(number);
+                    tagMasks[row] |= uint16_t(1) << tag;
+                }
+            }
+        }
+        size_t bytes = all.memoryBytes();
+        for (const Bitmap& bits : statusBits) {
+            bytes += bits.memoryBytes();
+        }
+        for (const auto& [tag, bits] : tagged) {
+            bytes += bits.memoryBytes();
+        }
+        auto resolve = [&](const string& word) -> const Bitmap* {
+            Status status;
+            if (parseStatusArgument(word, status)) {
+                return &statusBits[static_cast<size_t>(status)];
+            }
+            auto it = tagged.find(word);
+            return it == tagged.end() ? nullptr : &it->second;
+        };
+
+        for (size_t q = 0; q < size(QUERIES); ++q) {
+            string query = QUERIES[q];
+            vector<double> samples;
+            size_t matches = 0;
+            for (size_t i = 0; i < repeats; ++i) {
+                auto start = Clock::now();
+                Bitmap result;
+                string error;
+                FilterQuery(query, all, resolve).evaluate(result, error);
+                matches = result.cardinality();
+                samples.push_back(chrono::duration<double, micro>(Clock::now() - start).count());
+            }
+            auto start = Clock::now();
+            size_t scanned = 0;
+            for (size_t i = 0; i < 10; ++i) {
+                scanned = scan(q, statuses, tagMasks);
+            }
+            double scanUs = chrono::duration<double, micro>(Clock::now() - start).count() / 10;
+            if (scanned != matches) {
+                fprintf(stderr, "mismatch for '%s': %zu != %zu\n", QUERIES[q], matches, scanned);
+                return 1;
+            }
+            sink = sink + matches;
+            printf("%10zu %-44s %10zu %10.1f %10.1f %10.1f %10.0f\n", n, QUERIES[q], matches,
+                   percentile(samples, 0.5), percentile(samples, 0.99), scanUs, bytes / 1024.0);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+// Micro-benchmark for QuestionIndex lookups.
+// Builds indexes of 10k, 100k and 1M entries and reports the average latency of
+// point lookups, "jump to number", 500-wide range queries and adding then
+// removing a number, next to the linear scan over string numbers that
+// searchQuestion used before the index.
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../question_index.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+static volatile size_t sink; // Keeps the optimizer from discarding lookups
+
+template <typename Fn>
+static double nanosPerOp(size_t ops, Fn fn) {
+    auto start = Clock::now();
+    for (size_t i = 0; i < ops; ++i) {
+        fn(i);
+    }
+    auto elapsed = chrono::duration_cast<chrono::nanoseconds>(Clock::now() - start).count();
+    return static_cast<double>(elapsed) / ops;
+}
+
+int main() {
+    const size_t sizes[] = {10000, 100000, 1000000};
+    const size_t lookups = 1000000;
+    mt19937 rng(42);
+
+    printf("%10s %12s %12s %12s %12s %14s\n", "entries", "find ns", "jump ns", "range ns", "update ns", "linear ns");
+    for (size_t n : sizes) {
+        // Sparse, shuffled numbers like a real problem set with gaps
+        vector<IndexEntry> entries;
+        vector<string> textNumbers;
+        entries.reserve(n);
+        textNumbers.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            int number = static_cast<int>(i * 3 + 1);
+            entries.push_back({number, static_cast<uint32_t>(i)});
+            textNumbers.push_back(to_string(number));
+        }
+        shuffle(entries.begin(), entries.end(), rng);
+        QuestionIndex index;
+        index.build(entries);
+
+        vector<int> keys(lookups);
+        uniform_int_distribution<int> pick(1, static_cast<int>(n * 3));
+        for (int& key : keys) {
+            key = pick(rng);
+        }
+
+        double findNs = nanosPerOp(lookups, [&](size_t i) {
+            const IndexEntry* entry = index.find(keys[i]);
+            sink = sink + (entry ? entry->slot : 0);
+        });
+        double jumpNs = nanosPerOp(lookups, [&](size_t i) {
+            auto it = index.lowerBound(keys[i]);
+            sink = sink + (it != index.end() ? it->slot : 0);
+        });
+        double rangeNs = nanosPerOp(lookups / 10, [&](size_t i) {
+            auto bounds = index.range(keys[i], keys[i] + 500);
+            size_t count = 0;
+            for (auto it = bounds.first; it != bounds.second; ++it) {
+                count += it->slot;
+            }
+            sink = sink + count;
+        });
+        // Numbers 3k + 2 are never present, so each insert adds an entry
+        double updateNs = nanosPerOp(lookups, [&](size_t i) {
+            int number = keys[i] / 3 * 3 + 2;
+            index.insert(number, 0);
+            index.erase(number);
+        });
+        // The old linear scan is far slower, so sample fewer lookups
+        size_t linearOps = max<size_t>(10, 20000000 / n);
+        double linearNs = nanosPerOp(linearOps, [&](size_t i) {
+            string key = to_string(keys[i]);
+            for (size_t j = 0; j < textNumbers.size(); ++j) {
+                if (textNumbers[j] == key) {
+                    sink = sink + j;
+                    break;
+                }
+            }
+        });
+
+        printf("%10zu %12.1f %12.1f %12.1f %12.1f %14.1f\n", n, findNs, jumpNs, rangeNs, updateNs, linearNs);
+    }
+    return 0;
+}
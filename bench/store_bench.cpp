@@ -0,0 +1,97 @@
+// Resident memory of the question cache against a plain getQuestions() load.
+// Builds a database of 1M questions, then loads it once per representation in
+// a forked child so each measurement starts from the same heap, and reports
+// the growth in resident set size per question.
+//
+// Usage: store_bench [--dir=PATH] [--questions=N]
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../database.cpp"
+#include "../question_cache.h"
+
+using namespace std;
+
+// Resident set size in bytes, from /proc/self/statm.
+static size_t residentBytes() {
+    FILE* file = fopen("/proc/self/statm", "r");
+    unsigned long size = 0, resident = 0;
+    if (file) {
+        if (fscanf(file, "%lu %lu", &size, &resident) != 2) {
+            resident = 0;
+        }
+        fclose(file);
+    }
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+// Runs load in a child process after warming SQLite's page cache, and prints
+// how much the resident set grew while the result is held, next to the bytes
+// the representation accounts for itself (0 where it does not).
+template <typename Load>
+static void measure(const char* name, const string& path, size_t questions, Load load) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        Database db(path);
+        size_t rows = 0;
+        db.forEachQuestion([&](const QuestionView&) { return ++rows > 0; }); // Same page cache for every run
+        size_t before = residentBytes();
+        size_t reported = load(db);
+        size_t grown = residentBytes() - before;
+        printf("%-16s %8.1f MiB resident %8.1f bytes/question %8.1f accounted\n", name, grown / (1024.0 * 1024.0),
+               static_cast<double>(grown) / questions, static_cast<double>(reported) / questions);
+        fflush(stdout);
+        _exit(0);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+}
+
+int main(int argc, char** argv) {
+    string dir = "/tmp";
+    size_t questions = 1000000;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--dir=", 6) == 0) {
+            dir = argv[i] + 6;
+        } else if (strncmp(argv[i], "--questions=", 12) == 0) {
+            questions = strtoul(argv[i] + 12, nullptr, 10);
+        }
+    }
+
+    string path = dir + "/store_bench.db";
+    remove(path.c_str());
+    {
+        Database db(path);
+        for (size_t i = 0; i < questions; ++i) {
+            int number = static_cast<int>(i * 2 + 1);
+            db.stageImport(number, "Synthetic problem " + to_string(number) + " about arrays and graphs",
+                           static_cast<Status>(i % STATUS_COUNT), false);
+        }
+        size_t written;
+        db.mergeImport(false, written);
+    }
+
+    printf("%zu questions\n", questions);
+    measure("getQuestions()", path, questions, [](Database& db) {
+        static vector<Question> held; // Kept alive until the measurement is taken
+        held = db.getQuestions();
+        return size_t(0);
+    });
+    measure("QuestionCache", path, questions, [](Database& db) {
+        static QuestionCache* held = new QuestionCache(db);
+        held->refreshIfChanged();
+        return held->rowBytes();
+    });
+
+    remove(path.c_str());
+    remove((path + "-wal").c_str());
+    remove((path + "-shm").c_str());
+    return 0;
+}
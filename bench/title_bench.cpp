@@ -0,0 +1,154 @@
+// Micro-benchmark for TitleIndex fuzzy search.
+// Builds indexes of 10k, 100k and 1M titles made of Zipf-distributed words and
+// reports build time, memory, update cost and the p50/p99 latency of queries
+// typed exactly, with typos and as short word prefixes.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../title_index.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+static volatile size_t sink; // Keeps the optimizer from discarding searches
+
+static const char* const WORDS[] = {
+    "two", "sum", "array", "string", "tree", "binary", "search", "linked", "list", "cache", "lru", "lfu",
+    "matrix", "path", "graph", "number", "islands", "valid", "parentheses", "merge", "intervals", "sorted",
+    "rotate", "image", "word", "ladder", "ii", "iii", "iv", "maximum", "minimum", "subarray", "product",
+    "longest", "substring", "without", "repeating", "characters", "median", "of", "arrays", "palindrome",
+    "partition", "course", "schedule", "clone", "serialize", "deserialize", "kth", "largest", "element",
+    "stream", "trapping", "rain", "water", "jump", "game", "coin", "change", "edit", "distance", "house",
+    "robber", "climbing", "stairs", "unique", "paths", "decode", "ways", "spiral", "order", "insert", "delete",
+    "design", "twitter", "trie", "prefix", "range", "query", "mutable", "count", "smaller", "after", "self",
+};
+
+// Word frequencies in titles follow Zipf's law like any natural text: the
+// words above are the most common, then a long tail of invented ones.
+class Vocabulary {
+public:
+    explicit Vocabulary(mt19937& rng) {
+        for (const char* word : WORDS) {
+            words.push_back(word);
+        }
+        const char* consonants = "bcdfghklmnprstvwz";
+        const char* vowels = "aeiou";
+        while (words.size() < 5000) {
+            string word;
+            for (int syllables = 2 + rng() % 2; syllables > 0; --syllables) {
+                word += consonants[rng() % 17];
+                word += vowels[rng() % 5];
+            }
+            words.push_back(word);
+        }
+        double total = 0;
+        for (size_t rank = 1; rank <= words.size(); ++rank) {
+            total += 1.0 / rank;
+            cumulative.push_back(total);
+        }
+    }
+
+    string title(mt19937& rng) const {
+        uniform_real_distribution<double> draw(0, cumulative.back());
+        uniform_int_distribution<int> length(2, 6);
+        string title;
+        for (int i = length(rng); i > 0; --i) {
+            size_t rank = lower_bound(cumulative.begin(), cumulative.end(), draw(rng)) - cumulative.begin();
+            string next = words[min(rank, words.size() - 1)];
+            next[0] = static_cast<char>(next[0] - 'a' + 'A');
+            title += (title.empty() ? "" : " ") + next;
+        }
+        return title;
+    }
+
+private:
+    vector<string> words;
+    vector<double> cumulative;
+};
+
+// Drops, doubles or replaces one letter somewhere past the first two.
+static string typo(const string& text, mt19937& rng) {
+    if (text.size() < 4) {
+        return text;
+    }
+    uniform_int_distribution<size_t> at(2, text.size() - 2);
+    string changed = text;
+    size_t i = at(rng);
+    switch (rng() % 3) {
+        case 0: changed.erase(i, 1); break;
+        case 1: changed.insert(i, 1, changed[i]); break;
+        default: changed[i] = changed[i] == 'x' ? 'y' : 'x'; break;
+    }
+    return changed;
+}
+
+static double percentile(vector<double>& samples, double fraction) {
+    sort(samples.begin(), samples.end());
+    return samples[min(samples.size() - 1, static_cast<size_t>(fraction * (samples.size() - 1) + 0.5))];
+}
+
+int main() {
+    const size_t sizes[] = {10000, 100000, 1000000};
+    const size_t queries = 2000;
+    mt19937 rng(42);
+    Vocabulary vocabulary(rng);
+
+    printf("%10s %10s %10s %10s %11s %11s %11s %11s %11s %11s\n", "titles", "build ms", "MiB", "update us",
+           "exact p50", "exact p99", "typo p50", "typo p99", "prefix p50", "prefix p99");
+    for (size_t n : sizes) {
+        vector<string> titles;
+        titles.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            titles.push_back(vocabulary.title(rng));
+        }
+        TitleIndex index;
+        auto start = Clock::now();
+        for (size_t i = 0; i < n; ++i) {
+            index.insert(static_cast<int>(i + 1), titles[i]);
+        }
+        double buildMs = chrono::duration<double, milli>(Clock::now() - start).count();
+
+        // Replace random titles: one erase and one insert each
+        uniform_int_distribution<size_t> pick(0, n - 1);
+        const size_t updates = 10000;
+        start = Clock::now();
+        for (size_t i = 0; i < updates; ++i) {
+            size_t slot = pick(rng);
+            titles[slot] = vocabulary.title(rng);
+            index.insert(static_cast<int>(slot + 1), titles[slot]);
+        }
+        double updateUs = chrono::duration<double, micro>(Clock::now() - start).count() / updates;
+
+        // Queries are two or three consecutive words of a real title
+        vector<string> exact;
+        for (size_t i = 0; i < queries; ++i) {
+            const string& title = titles[pick(rng)];
+            size_t space = title.find(' ', title.find(' ') + 1);
+            exact.push_back(title.substr(0, space));
+        }
+        auto time = [&](const vector<string>& batch) {
+            vector<double> samples;
+            for (const string& query : batch) {
+                auto begin = Clock::now();
+                sink = sink + index.search(query, 100).size();
+                samples.push_back(chrono::duration<double, milli>(Clock::now() - begin).count());
+            }
+            return samples;
+        };
+        vector<string> typos, prefixes;
+        for (const string& query : exact) {
+            typos.push_back(typo(query, rng));
+            prefixes.push_back(query.substr(0, min<size_t>(query.size(), 5)));
+        }
+        vector<double> exactMs = time(exact), typoMs = time(typos), prefixMs = time(prefixes);
+        printf("%10zu %10.0f %10.1f %10.2f %11.3f %11.3f %11.3f %11.3f %11.3f %11.3f\n", n, buildMs,
+               index.memoryBytes() / (1024.0 * 1024.0), updateUs, percentile(exactMs, 0.5),
+               percentile(exactMs, 0.99), percentile(typoMs, 0.5), percentile(typoMs, 0.99),
+               percentile(prefixMs, 0.5), percentile(prefixMs, 0.99));
+    }
+    return 0;
+}
@@ -0,0 +1,480 @@
+#ifndef BITMAP_H
+#define BITMAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Compressed set of 32-bit integers, here question numbers, laid out like a
+// Roaring bitmap: values are grouped by their high 16 bits into containers
+// that hold the low 16 bits either as a sorted array (up to 4096 values, two
+// bytes each) or as a 65536-bit bitmap (8 KiB), whichever is smaller. A
+// sparse set costs about two bytes per value and a dense one a bit per
+// number in its range.
+//
+// AND, OR and AND NOT work one container at a time. Two bitmap containers
+// are combined 1024 words at a time, 256 bits per instruction when the
+// compiler targets AVX2, 128 with SSE2 (every x86-64 build) and 64 otherwise.
+// Their results stay bitmaps however few values remain: they are mostly
+// intermediate results of a query, and turning them back into arrays would
+// cost more than the operation. add() and remove() pick the smaller layout.
+class Bitmap {
+public:
+    size_t cardinality() const {
+        size_t total = 0;
+        for (const Container& container : containers) {
+            total += container.count;
+        }
+        return total;
+    }
+
+    bool empty() const {
+        return containers.empty();
+    }
+
+    void clear() {
+        containers.clear();
+    }
+
+    bool contains(uint32_t value) const {
+        const Container* container = find(static_cast<uint16_t>(value >> 16));
+        if (!container) {
+            return false;
+        }
+        uint16_t low = static_cast<uint16_t>(value);
+        if (container->dense()) {
+            return (container->words[low >> 6] >> (low & 63)) & 1;
+        }
+        return std::binary_search(container->values.begin(), container->values.end(), low);
+    }
+
+    // Returns false if the value was already present. Values added in
+    // ascending order, as when loading, are appended without a search.
+    bool add(uint32_t value) {
+        uint16_t key = static_cast<uint16_t>(value >> 16);
+        uint16_t low = static_cast<uint16_t>(value);
+        Container* container;
+        if (!containers.empty() && containers.back().key == key) {
+            container = &containers.back();
+        } else {
+            auto it = lowerBound(key);
+            if (it == containers.end() || it->key != key) {
+                Container created;
+                created.key = key;
+                it = containers.insert(it, std::move(created));
+            }
+            container = &*it;
+        }
+        if (container->dense()) {
+            uint64_t& word = container->words[low >> 6];
+            uint64_t bit = uint64_t(1) << (low & 63);
+            if (word & bit) {
+                return false;
+            }
+            word |= bit;
+            container->count++;
+            return true;
+        }
+        std::vector<uint16_t>& values = container->values;
+        if (values.empty() || values.back() < low) {
+            values.push_back(low);
+        } else {
+            auto position = std::lower_bound(values.begin(), values.end(), low);
+            if (*position == low) {
+                return false;
+            }
+            values.insert(position, low);
+        }
+        container->count++;
+        normalize(*container);
+        return true;
+    }
+
+    // Returns false if the value was not present.
+    bool remove(uint32_t value) {
+        uint16_t key = static_cast<uint16_t>(value >> 16);
+        uint16_t low = static_cast<uint16_t>(value);
+        auto it = lowerBound(key);
+        if (it == containers.end() || it->key != key) {
+            return false;
+        }
+        if (it->dense()) {
+            uint64_t& word = it->words[low >> 6];
+            uint64_t bit = uint64_t(1) << (low & 63);
+            if (!(word & bit)) {
+                return false;
+            }
+            word &= ~bit;
+        } else {
+            auto position = std::lower_bound(it->values.begin(), it->values.end(), low);
+            if (position == it->values.end() || *position != low) {
+                return false;
+            }
+            it->values.erase(position);
+        }
+        it->count--;
+        if (it->count == 0) {
+            containers.erase(it);
+        } else {
+            normalize(*it);
+        }
+        return true;
+    }
+
+    // this = this AND other
+    void intersectWith(const Bitmap& other) {
+        std::vector<Container> result;
+        size_t i = 0, j = 0;
+        while (i < containers.size() && j < other.containers.size()) {
+            Container& a = containers[i];
+            const Container& b = other.containers[j];
+            if (a.key < b.key) {
+                i++;
+            } else if (b.key < a.key) {
+                j++;
+            } else {
+                intersect(a, b);
+                if (a.count > 0) {
+                    result.push_back(std::move(a));
+                }
+                i++;
+                j++;
+            }
+        }
+        containers = std::move(result);
+    }
+
+    // this = this OR other
+    void uniteWith(const Bitmap& other) {
+        std::vector<Container> result;
+        result.reserve(containers.size() + other.containers.size());
+        size_t i = 0, j = 0;
+        while (i < containers.size() || j < other.containers.size()) {
+            if (j == other.containers.size() || (i < containers.size() && containers[i].key < other.containers[j].key)) {
+                result.push_back(std::move(containers[i++]));
+            } else if (i == containers.size() || other.containers[j].key < containers[i].key) {
+                result.push_back(other.containers[j++]);
+            } else {
+                unite(containers[i], other.containers[j++]);
+                result.push_back(std::move(containers[i++]));
+            }
+        }
+        containers = std::move(result);
+    }
+
+    // this = this AND NOT other
+    void subtract(const Bitmap& other) {
+        std::vector<Container> result;
+        result.reserve(containers.size());
+        size_t j = 0;
+        for (Container& a : containers) {
+            while (j < other.containers.size() && other.containers[j].key < a.key) {
+                j++;
+            }
+            if (j < other.containers.size() && other.containers[j].key == a.key) {
+                difference(a, other.containers[j]);
+            }
+            if (a.count > 0) {
+                result.push_back(std::move(a));
+            }
+        }
+        containers = std::move(result);
+    }
+
+    // Calls visit(value) for every value in ascending order until it returns false.
+    template <typename Visitor>
+    void forEach(Visitor visit) const {
+        for (const Container& container : containers) {
+            uint32_t high = uint32_t(container.key) << 16;
+            if (!container.dense()) {
+                for (uint16_t low : container.values) {
+                    if (!visit(high | low)) {
+                        return;
+                    }
+                }
+                continue;
+            }
+            for (size_t w = 0; w < WORDS; ++w) {
+                for (uint64_t word = container.words[w]; word != 0; word &= word - 1) {
+                    if (!visit(high | uint32_t(w * 64 + __builtin_ctzll(word)))) {
+                        return;
+                    }
+                }
+            }
+        }
+    }
+
+    // Approximate heap bytes held.
+    size_t memoryBytes() const {
+        size_t bytes = containers.capacity() * sizeof(Container);
+        for (const Container& container : containers) {
+            bytes += container.values.capacity() * sizeof(uint16_t) + container.words.capacity() * sizeof(uint64_t);
+        }
+        return bytes;
+    }
+
+private:
+    static constexpr size_t ARRAY_LIMIT = 4096; // Largest array container; past it a bitmap is smaller
+    static constexpr size_t WORDS = 1024;       // 64-bit words in a bitmap container
+
+    struct Container {
+        uint16_t key = 0;   // High 16 bits shared by the values
+        uint32_t count = 0; // Values held
+        std::vector<uint16_t> values; // Sorted low bits, while an array container
+        std::vector<uint64_t> words;  // WORDS words, once a bitmap container
+
+        bool dense() const {
+            return !words.empty();
+        }
+    };
+
+    std::vector<Container> containers; // In ascending key order, none empty
+
+    enum class WordOp { And, Or, AndNot };
+
+    std::vector<Container>::iterator lowerBound(uint16_t key) {
+        return std::lower_bound(containers.begin(), containers.end(), key,
+                                [](const Container& container, uint16_t k) { return container.key < k; });
+    }
+
+    const Container* find(uint16_t key) const {
+        auto it = std::lower_bound(containers.begin(), containers.end(), key,
+                                   [](const Container& container, uint16_t k) { return container.key < k; });
+        return it != containers.end() && it->key == key ? &*it : nullptr;
+    }
+
+    // Switches a container to whichever layout is smaller for its count.
+    static void normalize(Container& container) {
+        if (!container.dense() && container.count > ARRAY_LIMIT) {
+            container.words.assign(WORDS, 0);
+            for (uint16_t low : container.values) {
+                container.words[low >> 6] |= uint64_t(1) << (low & 63);
+            }
+            container.values.clear();
+            container.values.shrink_to_fit();
+        } else if (container.dense() && container.count <= ARRAY_LIMIT) {
+            container.values.clear();
+            container.values.reserve(container.count);
+            for (size_t w = 0; w < WORDS; ++w) {
+                for (uint64_t word = container.words[w]; word != 0; word &= word - 1) {
+                    container.values.push_back(static_cast<uint16_t>(w * 64 + __builtin_ctzll(word)));
+                }
+            }
+            container.words.clear();
+            container.words.shrink_to_fit();
+        }
+    }
+
+    static uint32_t popcount(uint64_t word) {
+#if defined(__POPCNT__)
+        return static_cast<uint32_t>(__builtin_popcountll(word));
+#else
+        // Without the instruction GCC calls a library routine; this inlines
+        word = word - ((word >> 1) & 0x5555555555555555ULL);
+        word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+        word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+        return static_cast<uint32_t>((word * 0x0101010101010101ULL) >> 56);
+#endif
+    }
+
+    // Bits set in each byte of v, by the first steps of popcount(); summing
+    // the bytes with SAD then counts a whole register at once.
+#if defined(__AVX2__)
+    static __m256i byteCounts(__m256i v) {
+        const __m256i ones = _mm256_set1_epi8(0x55), twos = _mm256_set1_epi8(0x33), fours = _mm256_set1_epi8(0x0f);
+        v = _mm256_sub_epi8(v, _mm256_and_si256(_mm256_srli_epi64(v, 1), ones));
+        v = _mm256_add_epi8(_mm256_and_si256(v, twos), _mm256_and_si256(_mm256_srli_epi64(v, 2), twos));
+        return _mm256_and_si256(_mm256_add_epi8(v, _mm256_srli_epi64(v, 4)), fours);
+    }
+#elif defined(__SSE2__)
+    static __m128i byteCounts(__m128i v) {
+        const __m128i ones = _mm_set1_epi8(0x55), twos = _mm_set1_epi8(0x33), fours = _mm_set1_epi8(0x0f);
+        v = _mm_sub_epi8(v, _mm_and_si128(_mm_srli_epi64(v, 1), ones));
+        v = _mm_add_epi8(_mm_and_si128(v, twos), _mm_and_si128(_mm_srli_epi64(v, 2), twos));
+        return _mm_and_si128(_mm_add_epi8(v, _mm_srli_epi64(v, 4)), fours);
+    }
+#endif
+
+    // a = a op b over two bitmap containers' words; returns the bits set in a,
+    // counted in the same pass.
+    template <WordOp op>
+    static uint32_t combine(uint64_t* a, const uint64_t* b) {
+#if defined(__AVX2__)
+        __m256i total = _mm256_setzero_si256();
+        for (size_t i = 0; i < WORDS; i += 4) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+            __m256i r = op == WordOp::And ? _mm256_and_si256(x, y)
+                      : op == WordOp::Or  ? _mm256_or_si256(x, y)
+                                          : _mm256_andnot_si256(y, x);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + i), r);
+            total = _mm256_add_epi64(total, _mm256_sad_epu8(byteCounts(r), _mm256_setzero_si256()));
+        }
+        return static_cast<uint32_t>(_mm256_extract_epi64(total, 0) + _mm256_extract_epi64(total, 1) +
+                                     _mm256_extract_epi64(total, 2) + _mm256_extract_epi64(total, 3));
+#elif defined(__SSE2__)
+        __m128i total = _mm_setzero_si128();
+        for (size_t i = 0; i < WORDS; i += 2) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            __m128i r = op == WordOp::And ? _mm_and_si128(x, y)
+                      : op == WordOp::Or  ? _mm_or_si128(x, y)
+                                          : _mm_andnot_si128(y, x);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(a + i), r);
+            total = _mm_add_epi64(total, _mm_sad_epu8(byteCounts(r), _mm_setzero_si128()));
+        }
+        return static_cast<uint32_t>(_mm_cvtsi128_si32(total) + _mm_cvtsi128_si32(_mm_srli_si128(total, 8)));
+#else
+        uint32_t count = 0;
+        for (size_t i = 0; i < WORDS; ++i) {
+            a[i] = op == WordOp::And ? a[i] & b[i] : op == WordOp::Or ? a[i] | b[i] : a[i] & ~b[i];
+            count += popcount(a[i]);
+        }
+        return count;
+#endif
+    }
+
+    // Array containers are combined by marking one of them in a bitset and
+    // testing the other's values against it, which runs at the speed of
+    // independent loads; a merge waits on every comparison before the next.
+    // Outputs may overwrite the tested values in place, since they never get
+    // ahead of them.
+
+    static void mark(const std::vector<uint16_t>& values, uint64_t* words) {
+        for (uint16_t low : values) {
+            words[low >> 6] |= uint64_t(1) << (low & 63);
+        }
+    }
+
+    // Values whose bit is set, or clear when keep is false.
+    static size_t filterArray(const uint16_t* values, size_t size, const uint64_t* words, bool keep, uint16_t* out) {
+        size_t k = 0;
+        for (size_t i = 0; i < size; ++i) {
+            out[k] = values[i];
+            k += static_cast<bool>((words[values[i] >> 6] >> (values[i] & 63)) & 1) == keep;
+        }
+        return k;
+    }
+
+    // Union of two sorted arrays, choosing the next value without a branch.
+    static size_t uniteArrays(const uint16_t* a, size_t aSize, const uint16_t* b, size_t bSize, uint16_t* out) {
+        size_t i = 0, j = 0, k = 0;
+        while (i < aSize && j < bSize) {
+            uint16_t x = a[i], y = b[j];
+            out[k++] = x < y ? x : y;
+            i += x <= y;
+            j += y <= x;
+        }
+        while (i < aSize) {
+            out[k++] = a[i++];
+        }
+        while (j < bSize) {
+            out[k++] = b[j++];
+        }
+        return k;
+    }
+
+    static void intersect(Container& a, const Container& b) {
+        if (a.dense() && b.dense()) {
+            a.count = combine<WordOp::And>(a.words.data(), b.words.data());
+            return;
+        }
+        size_t kept;
+        if (a.dense()) {
+            a.values.resize(b.values.size());
+            kept = filterArray(b.values.data(), b.values.size(), a.words.data(), true, a.values.data());
+            a.words.clear();
+            a.words.shrink_to_fit();
+        } else if (b.dense()) {
+            kept = filterArray(a.values.data(), a.values.size(), b.words.data(), true, a.values.data());
+        } else if (a.values.size() * 64 < b.values.size()) {
+            // Far smaller: look each value up in the other instead
+            kept = 0;
+            auto from = b.values.begin();
+            for (uint16_t low : a.values) {
+                from = std::lower_bound(from, b.values.end(), low);
+                if (from == b.values.end()) {
+                    break;
+                }
+                a.values[kept] = low;
+                kept += *from == low;
+            }
+        } else {
+            uint64_t marks[WORDS] = {};
+            if (b.values.size() < a.values.size()) {
+                mark(a.values, marks);
+                a.values.resize(b.values.size());
+                kept = filterArray(b.values.data(), b.values.size(), marks, true, a.values.data());
+            } else {
+                mark(b.values, marks);
+                kept = filterArray(a.values.data(), a.values.size(), marks, true, a.values.data());
+            }
+        }
+        a.values.resize(kept);
+        a.count = static_cast<uint32_t>(kept);
+    }
+
+    static void unite(Container& a, const Container& b) {
+        if (a.dense() && b.dense()) {
+            a.count = combine<WordOp::Or>(a.words.data(), b.words.data());
+            return;
+        }
+        if (a.dense() || b.dense()) {
+            // The array's values are marked into a's bitmap, which is a copy
+            // of b's only when a held the array
+            std::vector<uint16_t> taken;
+            const std::vector<uint16_t>* values = &b.values;
+            if (!a.dense()) {
+                taken.swap(a.values);
+                values = &taken;
+                a.words = b.words;
+                a.count = b.count;
+            }
+            for (uint16_t low : *values) {
+                uint64_t bit = uint64_t(1) << (low & 63);
+                a.count += !(a.words[low >> 6] & bit);
+                a.words[low >> 6] |= bit;
+            }
+            return;
+        }
+        std::vector<uint16_t> merged(a.values.size() + b.values.size());
+        merged.resize(uniteArrays(a.values.data(), a.values.size(), b.values.data(), b.values.size(), merged.data()));
+        a.values = std::move(merged);
+        a.count = static_cast<uint32_t>(a.values.size());
+        normalize(a);
+    }
+
+    static void difference(Container& a, const Container& b) {
+        if (a.dense()) {
+            if (b.dense()) {
+                a.count = combine<WordOp::AndNot>(a.words.data(), b.words.data());
+            } else {
+                for (uint16_t low : b.values) {
+                    uint64_t bit = uint64_t(1) << (low & 63);
+                    a.count -= (a.words[low >> 6] & bit) != 0;
+                    a.words[low >> 6] &= ~bit;
+                }
+            }
+            return;
+        }
+        size_t kept;
+        if (b.dense()) {
+            kept = filterArray(a.values.data(), a.values.size(), b.words.data(), false, a.values.data());
+        } else {
+            uint64_t marks[WORDS] = {};
+            mark(b.values, marks);
+            kept = filterArray(a.values.data(), a.values.size(), marks, false, a.values.data());
+        }
+        a.values.resize(kept);
+        a.count = static_cast<uint32_t>(kept);
+    }
+};
+
+#endif // BITMAP_H
@@ -0,0 +1,598 @@
+#ifndef CLI_H
+#define CLI_H
+
+#include <poll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "database.cpp"     // Include the Database class
+#include "question.h"       // Include the Question struct definition
+#include "question_index.h" // Include parseQuestionNumber
+#include "tag_filter.h"     // Include parseTagList
+#include "import.h"         // Include the bulk CSV/JSONL importer
+#include "export.h"         // Include BufferedWriter and the JSON writers
+
+// Reads lines from a file descriptor and can tell whether the next line is
+// already available without blocking, so batch mode knows when input has gone
+// idle and pending writes should be committed.
+class LineReader {
+public:
+    explicit LineReader(int fileDescriptor) : fd(fileDescriptor) {}
+
+    bool lineReady() {
+        if (buffer.find('\n', scanned) != string::npos || eof) {
+            return true;
+        }
+        struct pollfd input = {fd, POLLIN, 0};
+        return poll(&input, 1, 0) > 0;
+    }
+
+    bool next(string& line) {
+        while (true) {
+            size_t newline = buffer.find('\n', scanned);
+            if (newline != string::npos) {
+                line.assign(buffer, scanned, newline - scanned);
+                scanned = newline + 1;
+                return true;
+            }
+            if (eof) {
+                if (scanned < buffer.size()) {
+                    line.assign(buffer, scanned, string::npos);
+                    scanned = buffer.size();
+                    return true;
+                }
+                return false;
+            }
+            buffer.erase(0, scanned);
+            scanned = 0;
+            char chunk[65536];
+            ssize_t n = ::read(fd, chunk, sizeof(chunk));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                eof = true;
+            } else {
+                buffer.append(chunk, static_cast<size_t>(n));
+            }
+        }
+    }
+
+private:
+    int fd;
+    string buffer;
+    size_t scanned = 0; // Start of the first unread line in buffer
+    bool eof = false;
+};
+
+// Splits a batch line into arguments like a shell would for simple cases:
+// whitespace separates, single and double quotes group, and a backslash
+// escapes the next character outside single quotes.
+inline bool splitArguments(const string& line, vector<string>& args) {
+    args.clear();
+    string current;
+    bool inArgument = false;
+    char quote = 0;
+    for (size_t i = 0; i < line.size(); ++i) {
+        char c = line[i];
+        if (quote) {
+            if (c == quote) {
+                quote = 0;
+            } else if (c == '\\' && quote == '"' && i + 1 < line.size()) {
+                current += line[++i];
+            } else {
+                current += c;
+            }
+        } else if (c == '\'' || c == '"') {
+            quote = c;
+            inArgument = true;
+        } else if (c == '\\' && i + 1 < line.size()) {
+            current += line[++i];
+            inArgument = true;
+        } else if (c == ' ' || c == '\t' || c == '\r') {
+            if (inArgument) {
+                args.push_back(std::move(current));
+                current.clear();
+                inArgument = false;
+            }
+        } else {
+            current += c;
+            inArgument = true;
+        }
+    }
+    if (inArgument) {
+        args.push_back(std::move(current));
+    }
+    return quote == 0;
+}
+
+// Non-interactive commands over a Database, for scripts and cron jobs.
+// Results go to out as tab-separated lines or JSON Lines; errors go to stderr.
+class CommandRunner {
+public:
+    CommandRunner(Database& database, BufferedWriter& output, bool jsonOutput)
+        : db(database), out(output), json(jsonOutput) {}
+
+    // Runs one command. Returns false if it failed.
+    bool run(const vector<string>& args) {
+        if (args.empty()) {
+            return true;
+        }
+        const string& command = args[0];
+        if (command == "add") {
+            return add(args);
+        } else if (command == "set-status") {
+            return setStatus(args);
+        } else if (command == "get") {
+            return get(args);
+        } else if (command == "delete") {
+            return remove(args);
+        } else if (command == "list") {
+            return list(args);
+        } else if (command == "count") {
+            return count(args);
+        } else if (command == "due") {
+            return due(args);
+        } else if (command == "tag") {
+            return tag(args);
+        } else if (command == "tags") {
+            return tags(args);
+        }
+        return fail("unknown command '" + command + "'");
+    }
+
+    // Prefix for error messages, e.g. the batch line number.
+    void setContext(const string& prefix) {
+        context = prefix;
+    }
+
+private:
+    Database& db;
+    BufferedWriter& out;
+    bool json;
+    string context;
+
+    bool fail(const string& message) {
+        cerr << context << message << endl;
+        return false;
+    }
+
+    // Reports a failed database call with SQLite's reason, e.g. "database is locked".
+    bool failDatabase(const string& message) {
+        return fail(message + ": " + db.lastErrorMessage());
+    }
+
+    // Point lookup that tells a missing question apart from a failed read.
+    bool lookup(const string& command, int number, optional<Question>& question) {
+        question = db.getQuestion(number);
+        if (!question && db.lastError() != SQLITE_OK) {
+            return failDatabase(command + ": database read failed");
+        }
+        return true;
+    }
+
+    bool numberArgument(const vector<string>& args, size_t index, int& number) {
+        if (index >= args.size() || !parseQuestionNumber(args[index], number)) {
+            return fail(args[0] + ": expected a question number");
+        }
+        return true;
+    }
+
+    bool statusArgument(const vector<string>& args, size_t index, Status& status) {
+        if (index >= args.size() || !parseStatusArgument(args[index], status)) {
+            return fail(args[0] + ": expected a status (submitted, under-review, not-understood or 0-2)");
+        }
+        return true;
+    }
+
+    // Parses an optional trailing --status=NAME.
+    bool statusFilter(const vector<string>& args, optional<Status>& filter) {
+        for (size_t i = 1; i < args.size(); ++i) {
+            Status status;
+            if (args[i].rfind("--status=", 0) != 0 || !parseStatusArgument(args[i].substr(9), status)) {
+                return fail(args[0] + ": unexpected argument '" + args[i] + "'");
+            }
+            filter = status;
+        }
+        return true;
+    }
+
+    // With schedule set, adds the review due time and interval: as "due" and
+    // "interval" keys, or as a leading due<TAB> column.
+    void print(const QuestionView& question, bool schedule = false) {
+        if (json) {
+            out.put("{\"number\":");
+            out.putNumber(question.number);
+            out.put(",\"text\":");
+            writeJsonString(out, question.text);
+            out.put(",\"status\":\"");
+            out.put(statusName(question.status));
+            if (schedule) {
+                out.put("\",\"due\":");
+                out.putNumber(question.due);
+                out.put(",\"interval\":");
+                out.putNumber(question.interval);
+                out.put("}\n");
+                return;
+            }
+            out.put("\"}\n");
+            return;
+        }
+        if (schedule) {
+            out.putNumber(question.due);
+            out.put('\t');
+        }
+        out.putNumber(question.number);
+        out.put('\t');
+        out.put(statusName(question.status));
+        out.put('\t');
+        // Keep one question per line
+        size_t start = 0;
+        for (size_t i = 0; i < question.text.size(); ++i) {
+            char c = question.text[i];
+            if (c == '\n' || c == '\t' || c == '\\') {
+                out.put(question.text.substr(start, i - start));
+                out.put(c == '\n' ? "\\n" : c == '\t' ? "\\t" : "\\\\");
+                start = i + 1;
+            }
+        }
+        out.put(question.text.substr(start));
+        out.put('\n');
+    }
+
+    // add <number> <status> <text...>
+    bool add(const vector<string>& args) {
+        int number;
+        Status status;
+        if (!numberArgument(args, 1, number) || !statusArgument(args, 2, status)) {
+            return false;
+        }
+        string text;
+        for (size_t i = 3; i < args.size(); ++i) {
+            text += (i > 3 ? " " : "") + args[i];
+        }
+        if (text.empty()) {
+            return fail("add: expected question text");
+        }
+        optional<Question> existing;
+        if (!lookup("add", number, existing)) {
+            return false;
+        }
+        if (existing) {
+            return fail("add: question " + to_string(number) + " already exists");
+        }
+        return db.addQuestion(number, text, status) || failDatabase("add: database write failed");
+    }
+
+    // set-status <number> <status>
+    bool setStatus(const vector<string>& args) {
+        int number;
+        Status status;
+        if (!numberArgument(args, 1, number) || !statusArgument(args, 2, status)) {
+            return false;
+        }
+        optional<Question> existing;
+        if (!lookup("set-status", number, existing)) {
+            return false;
+        }
+        if (!existing) {
+            return fail("set-status: no question " + to_string(number));
+        }
+        return db.updateQuestionInDB(number, status) || failDatabase("set-status: database write failed");
+    }
+
+    // get <number>
+    bool get(const vector<string>& args) {
+        int number;
+        if (!numberArgument(args, 1, number)) {
+            return false;
+        }
+        optional<Question> question;
+        if (!lookup("get", number, question)) {
+            return false;
+        }
+        if (!question) {
+            return fail("get: no question " + to_string(number));
+        }
+        print({question->number, question->text, question->status});
+        return true;
+    }
+
+    // delete <number>
+    bool remove(const vector<string>& args) {
+        int number;
+        if (!numberArgument(args, 1, number)) {
+            return false;
+        }
+        optional<Question> existing;
+        if (!lookup("delete", number, existing)) {
+            return false;
+        }
+        if (!existing) {
+            return fail("delete: no question " + to_string(number));
+        }
+        return db.deleteQuestionFromDB(number) || failDatabase("delete: database write failed");
+    }
+
+    // list [--status=NAME]
+    bool list(const vector<string>& args) {
+        optional<Status> filter;
+        if (!statusFilter(args, filter)) {
+            return false;
+        }
+        return db.forEachQuestion([&](const QuestionView& question) {
+            print(question);
+            return out.ok();
+        }, filter) || failDatabase("list: database read failed");
+    }
+
+    // due [N]: the N (default 10) earliest-due questions in the review queue
+    bool due(const vector<string>& args) {
+        int limit = 10;
+        if (args.size() > 2 || (args.size() == 2 && !parseQuestionNumber(args[1], limit))) {
+            return fail("due: expected a number of questions");
+        }
+        vector<Question> questions = db.nextDue(limit);
+        if (questions.empty() && db.lastError() != SQLITE_OK) {
+            return failDatabase("due: database read failed");
+        }
+        for (const Question& question : questions) {
+            print({question.number, question.text, question.status, question.due, question.interval}, true);
+        }
+        return true;
+    }
+
+    // tag <number> [tags...]: replaces the question's tags; none clears them
+    bool tag(const vector<string>& args) {
+        int number;
+        if (!numberArgument(args, 1, number)) {
+            return false;
+        }
+        string list, invalid;
+        for (size_t i = 2; i < args.size(); ++i) {
+            list += args[i] + " ";
+        }
+        vector<string> names;
+        if (!parseTagList(list, names, invalid)) {
+            return fail("tag: invalid tag '" + invalid + "' (letters, digits and -_+#. only, not a status name)");
+        }
+        optional<Question> existing;
+        if (!lookup("tag", number, existing)) {
+            return false;
+        }
+        if (!existing) {
+            return fail("tag: no question " + to_string(number));
+        }
+        return db.setQuestionTags(number, names) || failDatabase("tag: database write failed");
+    }
+
+    // tags [number]: every tag in use with its question count, or one question's tags
+    bool tags(const vector<string>& args) {
+        int number;
+        if (args.size() > 2) {
+            return fail("tags: expected at most a question number");
+        }
+        if (args.size() == 2) {
+            if (!numberArgument(args, 1, number)) {
+                return false;
+            }
+            vector<string> names = db.questionTags(number);
+            if (names.empty() && db.lastError() != SQLITE_OK) {
+                return failDatabase("tags: database read failed");
+            }
+            for (const string& name : names) {
+                printTag(name, -1);
+            }
+            return true;
+        }
+        vector<pair<string, long long>> counts = db.tagCounts();
+        if (counts.empty() && db.lastError() != SQLITE_OK) {
+            return failDatabase("tags: database read failed");
+        }
+        for (const auto& [name, questions] : counts) {
+            printTag(name, questions);
+        }
+        return true;
+    }
+
+    // A tag name, with its question count unless that is negative.
+    void printTag(const string& name, long long questions) {
+        if (json) {
+            out.put("{\"tag\":");
+            writeJsonString(out, name);
+            if (questions >= 0) {
+                out.put(",\"count\":");
+                out.putNumber(questions);
+            }
+            out.put("}\n");
+            return;
+        }
+        out.put(name);
+        if (questions >= 0) {
+            out.put('\t');
+            out.putNumber(questions);
+        }
+        out.put('\n');
+    }
+
+    // count [--status=NAME]
+    bool count(const vector<string>& args) {
+        optional<Status> filter;
+        if (!statusFilter(args, filter)) {
+            return false;
+        }
+        long long total = db.countQuestions(filter);
+        if (total < 0) {
+            return failDatabase("count: database read failed");
+        }
+        if (json) {
+            out.put("{\"count\":");
+            out.putNumber(total);
+            out.put("}\n");
+        } else {
+            out.putNumber(total);
+            out.put('\n');
+        }
+        return true;
+    }
+};
+
+// Credentials for headless use: the user name from --user=NAME or
+// TRACKER_USER, the password from the first line read from --password-fd=N or
+// from TRACKER_PASSWORD.
+inline bool readCredentials(const string& userOption, int passwordFd, string& username, string& password) {
+    const char* userEnv = getenv("TRACKER_USER");
+    username = !userOption.empty() ? userOption : userEnv ? userEnv : "";
+    if (passwordFd >= 0) {
+        LineReader reader(passwordFd);
+        if (!reader.next(password)) {
+            password.clear();
+        }
+        if (!password.empty() && password.back() == '\r') {
+            password.pop_back();
+        }
+    } else if (const char* passwordEnv = getenv("TRACKER_PASSWORD")) {
+        password = passwordEnv;
+    }
+    return !username.empty() && !password.empty();
+}
+
+inline void printCliUsage() {
+    cerr << "Usage: tui_program [--json] [--user=NAME] [--password-fd=N] <command> [args]\n"
+            "Commands:\n"
+            "  add <number> <status> <text...>\n"
+            "  set-status <number> <status>\n"
+            "  get <number>\n"
+            "  delete <number>\n"
+            "  list [--status=NAME]\n"
+            "  count [--status=NAME]\n"
+            "  due [N]                  the N earliest-due questions to review\n"
+            "  tag <number> [tags...]   replace a question's tags; none clears them\n"
+            "  tags [number]            every tag with its question count, or one question's tags\n"
+            "  batch                    read one command per line from stdin\n"
+            "  import <file> [options]  see README\n"
+            "  export [file] [options]  see README\n"
+            "Credentials come from TRACKER_USER and TRACKER_PASSWORD unless given as options.\n";
+}
+
+// Entry point for every command-line invocation with arguments. Skips ncurses
+// and the question cache entirely. Returns the process exit code.
+// With statsDump set, the latency and cache report is written there on exit.
+inline int runCli(const string& dbName, int argc, char** argv, const optional<string>& statsDump = nullopt) {
+    bool json = false;
+    string userOption;
+    int passwordFd = -1;
+    int first = 1;
+    for (; first < argc && strncmp(argv[first], "--", 2) == 0; ++first) {
+        string arg = argv[first];
+        if (arg == "--json") {
+            json = true;
+        } else if (arg.rfind("--user=", 0) == 0) {
+            userOption = arg.substr(7);
+        } else if (arg.rfind("--password-fd=", 0) == 0) {
+            passwordFd = atoi(arg.c_str() + 14);
+        } else {
+            printCliUsage();
+            return 2;
+        }
+    }
+    if (first >= argc) {
+        printCliUsage();
+        return 2;
+    }
+    string command = argv[first];
+    if (command == "help" || command == "-h") {
+        printCliUsage();
+        return 0;
+    }
+
+    string username;
+    string password;
+    if (!readCredentials(userOption, passwordFd, username, password)) {
+        cerr << "Credentials required: set TRACKER_USER and TRACKER_PASSWORD, or pass --user and --password-fd" << endl;
+        return 2;
+    }
+
+    bool batch = command == "batch";
+    DatabaseOptions options;
+    if (batch) {
+        // Commands arriving back to back share a transaction; see runBatch
+        options.groupCommitOps = 1024;
+        options.groupCommitWindowMs = 1000;
+    }
+    Database db(dbName, withEnvironmentOverrides(options));
+    if (!db.signIn(username, password)) {
+        if (db.lastError() != SQLITE_OK) {
+            cerr << "Cannot read users: " << db.lastErrorMessage() << endl;
+        } else {
+            cerr << "Invalid username or password" << endl;
+        }
+        return 1;
+    }
+
+    if (command == "import" || command == "export") {
+        int rest = argc - first - 1;
+        char** restArgs = argv + first + 1;
+        int status = command == "import" ? runImport(dbName, db.user(), rest, restArgs)
+                                         : runExport(dbName, db.user(), rest, restArgs);
+        if (statsDump) {
+            writeStatsDump(*statsDump, db.statsReport());
+        }
+        return status;
+    }
+
+    BufferedWriter out(STDOUT_FILENO);
+    CommandRunner runner(db, out, json);
+    bool ok = true;
+    if (!batch) {
+        ok = runner.run(vector<string>(argv + first, argv + argc));
+    } else {
+        // Pending writes and output are flushed whenever stdin has nothing
+        // more queued, so an interactive caller sees each reply promptly
+        // while piped input is committed in large batches.
+        LineReader input(STDIN_FILENO);
+        string line;
+        vector<string> args;
+        size_t lineNumber = 0;
+        while (input.next(line)) {
+            lineNumber++;
+            runner.setContext("line " + to_string(lineNumber) + ": ");
+            size_t start = line.find_first_not_of(" \t\r");
+            if (start == string::npos || line[start] == '#') {
+                continue;
+            }
+            if (!splitArguments(line, args)) {
+                cerr << "line " << lineNumber << ": unterminated quote" << endl;
+                ok = false;
+            } else if (args[0] == "batch" || args[0] == "import" || args[0] == "export") {
+                cerr << "line " << lineNumber << ": " << args[0] << " is not available in batch mode" << endl;
+                ok = false;
+            } else if (!runner.run(args)) {
+                ok = false;
+            }
+            if (!input.lineReady()) {
+                ok = db.flush() && ok;
+                out.flush();
+            }
+        }
+    }
+    if (!db.flush()) {
+        ok = false;
+    }
+    if (!out.flush()) {
+        cerr << "Cannot write output: " << strerror(out.error()) << endl;
+        ok = false;
+    }
+    if (statsDump) {
+        writeStatsDump(*statsDump, db.statsReport());
+    }
+    return ok ? 0 : 1;
+}
+
+#endif // CLI_H
@@ -1,113 +1,823 @@
+#ifndef DATABASE_CPP
+#define DATABASE_CPP
+
+#include <array>
 #include <iostream>
 #include <sqlite3.h>
 #include <string>
 #include <vector>
+#include <unordered_map>     // For the prepared statement cache
+#include <functional>        // For row visitors
+#include <optional>          // For optional status filters
+#include <string_view>       // For zero-copy row views
+#include <algorithm>         // For reverse
+#include <cctype>            // For isalnum
+#include <chrono>            // For the group commit window
+#include <cstdlib>           // For getenv
+#include <thread>            // For busy backoff sleeps
+#include <random>            // For busy backoff jitter
 #include <openssl/sha.h>    // For SHA-256 hashing
 #include <sstream>          // For string stream
 #include <iomanip>           // For hex formatting
 
 #include "question.h" // Include the Question struct definition
+#include "latency.h"  // Include the per-operation latency histograms
 
 using namespace std;
 
+// SQL for the local calendar day of a Unix time, as days since 1970-01-01.
+// The status summaries and the dashboard must agree on it.
+#define LOCAL_DAY(unixTime) "CAST(julianday(" unixTime ", 'unixepoch', 'localtime') - 2440587.5 AS INTEGER)"
+// questions_fts rowid of a questions row: each user owns the 2^32 rowids
+// centred on user_id << 32, so a user's entries form one contiguous range.
+#define FTS_ROWID(row) "((" row ".user_id << 32) + " row ".number)"
+// Status values that keep a question in the review queue, as inReview().
+#define REVIEW_STATUSES "(1, 2)"
+
+// Keeps one prepared statement per SQL string for the lifetime of the connection.
+// acquire() hands back a statement that is reset and has its bindings cleared,
+// so callers only bind and step; wrap it in a StatementReset to release it.
+// Statements are keyed on the SQL pointer, not its text, so the SQL must be a
+// string literal (or otherwise outlive the cache and never change).
+class StatementCache {
+public:
+    StatementCache() = default;
+    StatementCache(const StatementCache&) = delete;
+    StatementCache& operator=(const StatementCache&) = delete;
+
+    ~StatementCache() {
+        clear();
+    }
+
+    void attach(sqlite3* connection) {
+        db = connection;
+    }
+
+    sqlite3_stmt* acquire(const char* sql) {
+        auto it = statements.find(sql);
+        if (it != statements.end()) {
+            hitCount++;
+            sqlite3_reset(it->second);
+            sqlite3_clear_bindings(it->second);
+            return it->second;
+        }
+        missCount++;
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v3(db, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK) {
+            return nullptr; // The connection's error, which Database::acquire() records
+        }
+        statements.emplace(sql, stmt);
+        return stmt;
+    }
+
+    void clear() {
+        for (auto& entry : statements) {
+            sqlite3_finalize(entry.second);
+        }
+        statements.clear();
+    }
+
+    size_t hits() const { return hitCount; }
+    size_t misses() const { return missCount; }
+    size_t size() const { return statements.size(); }
+
+private:
+    sqlite3* db = nullptr;
+    unordered_map<const char*, sqlite3_stmt*> statements;
+    size_t hitCount = 0;
+    size_t missCount = 0;
+};
+
+// Resets a cached statement when it goes out of scope so that an unfinished
+// SELECT does not keep its read transaction open between calls.
+struct StatementReset {
+    sqlite3_stmt* stmt;
+    ~StatementReset() {
+        if (stmt) {
+            sqlite3_reset(stmt);
+        }
+    }
+};
+
+// Connection settings. Group commit collects question writes into one explicit
+// transaction that commits after groupCommitOps writes or groupCommitWindowMs,
+// whichever comes first; 0 or 1 ops keeps SQLite's one-transaction-per-write.
+// busyTimeoutMs bounds how long a statement waits, backing off between retries,
+// for a lock held by another connection or process before failing with SQLITE_BUSY.
+// logErrors writes failed statements to stderr; lastError() and
+// lastErrorMessage() report them either way.
+struct DatabaseOptions {
+    bool wal = true;                  // journal_mode=WAL instead of a rollback journal
+    string synchronous = "NORMAL";    // OFF, NORMAL, FULL or EXTRA
+    size_t groupCommitOps = 0;
+    int groupCommitWindowMs = 50;
+    int busyTimeoutMs = 5000;
+    bool logErrors = true;
+};
+
+// Applies overrides from TRACKER_SYNCHRONOUS, TRACKER_GROUP_COMMIT_OPS,
+// TRACKER_GROUP_COMMIT_MS and TRACKER_BUSY_TIMEOUT_MS, when set.
+inline DatabaseOptions withEnvironmentOverrides(DatabaseOptions options) {
+    if (const char* value = getenv("TRACKER_SYNCHRONOUS")) {
+        options.synchronous = value;
+    }
+    if (const char* value = getenv("TRACKER_GROUP_COMMIT_OPS")) {
+        options.groupCommitOps = strtoul(value, nullptr, 10);
+    }
+    if (const char* value = getenv("TRACKER_GROUP_COMMIT_MS")) {
+        options.groupCommitWindowMs = atoi(value);
+    }
+    if (const char* value = getenv("TRACKER_BUSY_TIMEOUT_MS")) {
+        options.busyTimeoutMs = atoi(value);
+    }
+    return options;
+}
+
+// Status moves on one local calendar day, or over all recorded history: how
+// many questions entered and left each status. Adding a question enters its
+// status, deleting one leaves it, and a status change does both.
+struct StatusMoves {
+    long long day = 0; // Days since 1970-01-01 in local time
+    array<long long, STATUS_COUNT> entered{};
+    array<long long, STATUS_COUNT> left{};
+};
+
+// What the progress dashboard shows, read from the summary tables only.
+struct ProgressSummary {
+    long long today = 0;      // Local day number, as in StatusMoves::day
+    long long firstDay = -1;  // Earliest day with recorded moves, or -1 if none
+    vector<StatusMoves> days; // Days since the requested start that had moves, ascending
+    StatusMoves total;        // Every move recorded since history began
+};
+
 class Database {
 public:
-    Database(const string& dbName) {
+    Database(const string& dbName, const DatabaseOptions& databaseOptions = {}) : options(databaseOptions) {
+        TRACK_LATENCY("Database::open");
         if (sqlite3_open(dbName.c_str(), &db) != SQLITE_OK) {
             cerr << "Cannot open database: " << sqlite3_errmsg(db) << endl;
         } else {
+            statements.attach(db);
+            sqlite3_busy_handler(db, backoff, this); // Other connections and processes share the file
+            configure();
             createTable();
         }
     }
 
+    Database(const Database&) = delete;
+    Database& operator=(const Database&) = delete;
+
     ~Database() {
+        flush(); // Commit any group-commit batch still open
+        statements.clear(); // Statements must be finalized before the connection closes
         sqlite3_close(db);
     }
 
+    // Prepared statement cache counters
+    size_t statementCacheHits() const { return statements.hits(); }
+    size_t statementCacheMisses() const { return statements.misses(); }
+
+    // SQLite result code of the most recent statement on this connection, or
+    // SQLITE_OK if it succeeded. Methods that return a value rather than a
+    // success flag (an empty page, nullopt, -1) leave the reason here, so
+    // callers can tell "not found" from "could not read".
+    int lastError() const { return errorCode; }
+    const string& lastErrorMessage() const { return errorMessage; }
+
+    // Waits for locks held by other connections: how many times, and for how long in total.
+    size_t busyWaits() const { return busyWaitCount; }
+    long long busyWaitMs() const { return busyWaitTotalMs; }
+
+    // Latency table for every instrumented operation (all connections), then
+    // this connection's SQLite page cache and prepared statement cache counters.
+    vector<string> statsReport() {
+        vector<string> lines = formatLatencyTable();
+        int hits = 0, misses = 0, used = 0, highwater = 0;
+        sqlite3_db_status(db, SQLITE_DBSTATUS_CACHE_HIT, &hits, &highwater, 0);
+        sqlite3_db_status(db, SQLITE_DBSTATUS_CACHE_MISS, &misses, &highwater, 0);
+        sqlite3_db_status(db, SQLITE_DBSTATUS_CACHE_USED, &used, &highwater, 0);
+        char line[160];
+        double hitRate = hits + misses > 0 ? 100.0 * hits / (hits + misses) : 0.0;
+        snprintf(line, sizeof(line), "SQLite page cache: %d hits, %d misses (%.1f%% hit rate), %.1f KiB used",
+                 hits, misses, hitRate, used / 1024.0);
+        lines.push_back("");
+        lines.push_back(line);
+        snprintf(line, sizeof(line), "Prepared statements: %zu cached, %zu hits, %zu misses",
+                 statements.size(), statements.hits(), statements.misses());
+        lines.push_back(line);
+        snprintf(line, sizeof(line), "Lock waits: %zu, %lld ms in total", busyWaitCount, busyWaitTotalMs);
+        lines.push_back(line);
+        return lines;
+    }
+
     void createTable() {
         const char* sql = "CREATE TABLE IF NOT EXISTS users ("
-                         "username TEXT PRIMARY KEY,"
+                         "id INTEGER PRIMARY KEY AUTOINCREMENT," // Never reused, so rows cannot pass to a new user
+                         "username TEXT NOT NULL UNIQUE,"
                          "password TEXT NOT NULL);"
                          "CREATE TABLE IF NOT EXISTS questions ("
-                         "number TEXT PRIMARY KEY,"
+                         "user_id INTEGER NOT NULL," // Owner, users.id
+                         "number INTEGER NOT NULL,"
                          "text TEXT NOT NULL,"
-                         "status TEXT NOT NULL);";
-        char* errMsg;
-        if (sqlite3_exec(db, sql, nullptr, 0, &errMsg) != SQLITE_OK) {
-            cerr << "SQL error: " << errMsg << endl;
-            sqlite3_free(errMsg);
+                         "status INTEGER NOT NULL," // Status enum value
+                         "due INTEGER," // Unix time the next review is due, NULL when not in the review queue
+                         "interval_days INTEGER NOT NULL DEFAULT 0," // Days between the last two reviews
+                         "PRIMARY KEY (user_id, number)) WITHOUT ROWID;"; // Each user's rows stored together in number order
+        if (!execute(sql)) {
+            return;
         }
+        if (!migrateSchema()) {
+            return; // The file stays at its old version, untouched
+        }
+        // Counts per status are answered from this index alone, and since it
+        // carries the primary key it is in (user_id, status, number) order for
+        // keyset pages over a single status.
+        execute("CREATE INDEX IF NOT EXISTS questions_user_status ON questions(user_id, status);");
+        // Only queued questions, in (user_id, due, number) order for nextDue()
+        execute("CREATE INDEX IF NOT EXISTS questions_due ON questions(user_id, due) WHERE due IS NOT NULL;");
     }
 
-    void addQuestion(const string& number, const string& text, const string& status) {
-    cout << "Adding question: " << text << " with number: " << number << " and status: " << status << endl; // Debug output
-        const char* sql = "INSERT INTO questions (number, text, status) VALUES (?, ?, ?);";
-        sqlite3_stmt* stmt;
-        sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-        sqlite3_bind_text(stmt, 1, number.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 2, text.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 3, status.c_str(), -1, SQLITE_STATIC);
-        sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
+    // Scopes every question query and write on this connection to one user,
+    // as signIn() does. Connections that never sign in use user 0.
+    void setUser(long long id) {
+        userId = id;
+    }
+
+    long long user() const {
+        return userId;
+    }
+
+    bool addQuestion(int number, const string& text, Status status) {
+        TRACK_LATENCY("Database::addQuestion");
+        // Questions added in a review status are due for review right away
+        const char* sql = "INSERT INTO questions (user_id, number, text, status, due) "
+                          "VALUES (?, ?, ?, ?, CASE WHEN ?4 IN " REVIEW_STATUSES " THEN strftime('%s', 'now') END);";
+        sqlite3_stmt* stmt = acquire(sql);
+        if (!stmt || !joinBatch()) {
+            return false;
+        }
+        StatementReset reset{stmt};
+        sqlite3_bind_int64(stmt, 1, userId);
+        sqlite3_bind_int(stmt, 2, number);
+        sqlite3_bind_text(stmt, 3, text.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 4, static_cast<int>(status));
+        return noteWrite(step(stmt) == SQLITE_DONE);
+    }
+
+    // Bulk import: rows are staged in a temporary table and merged into
+    // questions by mergeImport() with a single INSERT ... SELECT, so the status
+    // index and full-text triggers run once per batch instead of once per row.
+    // The batch transaction stays open until the merge commits it.
+    bool stageImport(int number, const string& text, Status status, bool overwrite) {
+        TRACK_LATENCY("Database::stageImport");
+        if (!stagingReady) {
+            stagingReady = execute("CREATE TEMP TABLE IF NOT EXISTS import_staging ("
+                                   "number INTEGER PRIMARY KEY, text TEXT NOT NULL, status INTEGER NOT NULL);");
+            if (!stagingReady) {
+                return false;
+            }
+        }
+        // Within one batch the first row wins when skipping, the last when overwriting
+        const char* sql = overwrite
+            ? "INSERT OR REPLACE INTO import_staging (number, text, status) VALUES (?, ?, ?);"
+            : "INSERT OR IGNORE INTO import_staging (number, text, status) VALUES (?, ?, ?);";
+        sqlite3_stmt* stmt = acquire(sql);
+        if (!stmt || (!batchOpen && !openBatch())) {
+            return false;
+        }
+        StatementReset reset{stmt};
+        sqlite3_bind_int(stmt, 1, number);
+        sqlite3_bind_text(stmt, 2, text.c_str(), static_cast<int>(text.size()), SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 3, static_cast<int>(status));
+        return step(stmt) == SQLITE_DONE;
+    }
+
+    // Moves the staged rows into questions and commits. Existing numbers are
+    // overwritten or left alone; written receives how many rows were stored.
+    bool mergeImport(bool overwrite, size_t& written) {
+        TRACK_LATENCY("Database::mergeImport");
+        written = 0;
+        if (!batchOpen) {
+            return true;
+        }
+        // Imported rows in a review status join the queue, due now; rows
+        // already queued keep their schedule unless they leave the queue
+        const char* sql = overwrite
+            ? "INSERT INTO questions (user_id, number, text, status, due) "
+              "SELECT ?, number, text, status, CASE WHEN status IN " REVIEW_STATUSES " THEN strftime('%s', 'now') END "
+              "FROM import_staging WHERE true ON CONFLICT (user_id, number) DO UPDATE SET "
+              "text = excluded.text, status = excluded.status, "
+              "due = CASE WHEN excluded.due IS NOT NULL THEN coalesce(due, excluded.due) END, "
+              "interval_days = CASE WHEN excluded.due IS NOT NULL THEN interval_days ELSE 0 END;"
+            : "INSERT OR IGNORE INTO questions (user_id, number, text, status, due) "
+              "SELECT ?, number, text, status, CASE WHEN status IN " REVIEW_STATUSES " THEN strftime('%s', 'now') END "
+              "FROM import_staging;";
+        sqlite3_stmt* stmt = acquire(sql);
+        bool merged = false;
+        if (stmt) {
+            StatementReset reset{stmt};
+            sqlite3_bind_int64(stmt, 1, userId);
+            merged = step(stmt) == SQLITE_DONE;
+        }
+        if (!merged) {
+            rollbackIfOpen(); // Also discards the staged rows
+            batchOpen = false;
+            return false;
+        }
+        written = static_cast<size_t>(sqlite3_changes(db));
+        return execute("DELETE FROM import_staging;") && flush();
     }
 
     vector<Question> getQuestions() { // Ensure this returns a vector of Question objects
-    cout << "Retrieving questions from the database..." << endl; // Debug output
+        TRACK_LATENCY("Database::getQuestions");
         vector<Question> questions; // Change to store Question objects
-        const char* sql = "SELECT * FROM questions;";
-        sqlite3_stmt* stmt;
-        sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
-            string number = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-            string text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-            string status = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-            questions.push_back({text, status, number}); // Create Question object
-        }
-        sqlite3_finalize(stmt);
+        scanQuestions([&](const Question& question) {
+            questions.push_back(question);
+            return true;
+        });
         return questions;
     }
 
-    void updateQuestionInDB(const string& questionNumber, const string& newStatus) {
-        const char* sql = "UPDATE questions SET status = ? WHERE number = ?;";
-        sqlite3_stmt* stmt;
-        sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-        sqlite3_bind_text(stmt, 1, newStatus.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 2, questionNumber.c_str(), -1, SQLITE_STATIC);
-        sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
+    // Streams every question, borrowed as in forEachQuestion, plus the change
+    // log position they reflect, read in one snapshot so that
+    // changesSince(sequence) picks up exactly what came after. Returns false on
+    // a database error; whatever was visited by then should be discarded.
+    bool loadQuestions(const function<void(const QuestionView&)>& visit, long long& sequence) {
+        TRACK_LATENCY("Database::loadQuestions");
+        bool snapshot = sqlite3_get_autocommit(db) && execute("BEGIN;");
+        bool ok = (sequence = changeSequence()) >= 0 && forEachQuestion([&](const QuestionView& question) {
+            visit(question);
+            return true;
+        });
+        if (snapshot) {
+            execute("COMMIT;"); // Read-only; nothing to lose if this fails
+        }
+        return ok;
     }
 
-    void deleteQuestionFromDB(const string& questionNumber) {
-        const char* sql = "DELETE FROM questions WHERE number = ?;";
-        sqlite3_stmt* stmt;
-        sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-        sqlite3_bind_text(stmt, 1, questionNumber.c_str(), -1, SQLITE_STATIC);
-        sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
+    // Streams every question in ascending number order straight from the table
+    // B-tree. The visitor returns false to stop early. Returns false on a database error.
+    bool scanQuestions(const function<bool(const Question&)>& visit) {
+        TRACK_LATENCY("Database::scanQuestions");
+        const char* sql = "SELECT number, text, status FROM questions WHERE user_id = ? ORDER BY number;";
+        sqlite3_stmt* stmt = acquire(sql);
+        if (!stmt) {
+            return false;
+        }
+        StatementReset reset{stmt};
+        sqlite3_bind_int64(stmt, 1, userId);
+        return finished(streamRows(stmt, visit));
     }
 
-    void deleteAllQuestionsFromDB() {
-        const char* sql = "DELETE FROM questions;";
-        char* errMsg;
-        if (sqlite3_exec(db, sql, nullptr, 0, &errMsg) != SQLITE_OK) {
-            cerr << "SQL error: " << errMsg << endl;
-            sqlite3_free(errMsg);
+    // Position of the newest entry in the change log, 0 if it is empty, or -1 on error.
+    long long changeSequence() {
+        const char* sql = "SELECT coalesce(max(seq), 0) FROM question_changes;";
+        sqlite3_stmt* stmt = acquire(sql);
+        if (!stmt) {
+            return -1;
         }
+        StatementReset reset{stmt};
+        return step(stmt) == SQLITE_ROW ? sqlite3_column_int64(stmt, 0) : -1;
+    }
+
+    // Replays what every connection changed after the given change log position:
+    // visit gets each affected question as it is now with its tags in name
+    // order, or just its number with nullptr if it was deleted. sequence is
+    // advanced to the newest position.
+    // Returns false if the log no longer reaches back that far or on a database
+    // error; the caller should then load everything again.
+    bool changesSince(long long& sequence,
+                      const function<void(int number, const Question* question, const vector<string>& tags)>& visit) {
+        TRACK_LATENCY("Database::changesSince");
+        bool snapshot = sqlite3_get_autocommit(db) && execute("BEGIN;");
+        bool ok = replayChanges(sequence, visit);
+        if (snapshot) {
+            execute("COMMIT;");
+        }
+        return ok;
+    }
+
+    // Zero-copy scan for bulk readers such as export: rows are visited in number
+    // order, optionally restricted to one status, without copying the text.
+    // The visitor returns false to stop early. Returns false on a database error.
+    bool forEachQuestion(const function<bool(const QuestionView&)>& visit, optional<Status> filter = nullopt) {
+        TRACK_LATENCY("Database::forEachQuestion");
+        const char* sql = filter
+            ? "SELECT number, text, status, due, interval_days FROM questions "
+              "WHERE user_id = ? AND status = ? ORDER BY number;"
+            : "SELECT number, text, status, due, interval_days FROM questions WHERE user_id = ? ORDER BY number;";
+        sqlite3_stmt* stmt = acquire(sql);
+        if (!stmt) {
+            return false;
+        }
+        StatementReset reset{stmt};
+        sqlite3_bind_int64(stmt, 1, userId);
+        if (filter) {
+            sqlite3_bind_int(stmt, 2, static_cast<int>(*filter));
+        }
+        QuestionView view;
+        int rc;
+        while ((rc = step(stmt)) == SQLITE_ROW) {
+            view.number = sqlite3_column_int(stmt, 0);
+            const unsigned char* text = sqlite3_column_text(stmt, 1);
+            view.text = string_view(reinterpret_cast<const char*>(text), sqlite3_column_bytes(stmt, 1));
+            if (!readStatus(stmt, 2, view.status)) {
+                continue; // Not a status this program knows, see readStatus()
+            }
+            view.due = sqlite3_column_int64(stmt, 3); // NULL reads as 0
+            view.interval = sqlite3_column_int(stmt, 4);
+            if (!visit(view)) {
+                return true;
+            }
+        }
+        return rc == SQLITE_DONE;
+    }
+
+    // Point lookup by number. nullopt with lastError() set means the read failed.
+    optional<Question> getQuestion(int number) {
+        TRACK_LATENCY("Database::getQuestion");
+        const char* sql = "SELECT number, text, status FROM questions WHERE user_id = ? AND number = ?;";
+        sqlite3_stmt* stmt = acquire(sql);
+        if (!stmt) {
+            return nullopt;
+        }
+        StatementReset reset{stmt};
+        sqlite3_bind_int64(stmt, 1, userId);
+        sqlite3_bind_int(stmt, 2, number);
+        optional<Question> found;
+        streamRows(stmt, [&](const Question& question) {
+            found = question;
+            return false;
+        });
+        return found;
+    }
+
+    // Number of questions, optionally with one status. Returns -1 on error.
+    long long countQuestions(optional<Status> filter = nullopt) {
+        TRACK_LATENCY("Database::countQuestions");
+        const char* sql = filter
+            ? "SELECT COUNT(*) FROM questions WHERE user_id = ? AND status = ?;"
+            : "SELECT COUNT(*) FROM questions WHERE user_id = ?;";
+        sqlite3_stmt* stmt = acquire(sql);
+        if (!stmt) {
+            return -1;
+        }
+        StatementReset reset{stmt};
+        sqlite3_bind_int64(stmt, 1, userId);
+        if (filter) {
+            sqlite3_bind_int(stmt, 2, static_cast<int>(*filter));
+        }
+        if (step(stmt) == SQLITE_ROW) {
+            return sqlite3_column_int64(stmt, 0);
+        }
+        return -1;
+    }
+
+    // Fills summary with the moves of the last `days` local days (today
+    // included) and the all-time totals. Reads only the per-day and per-status
+    // summary tables, so the cost does not grow with the history. Returns
+    // false on a database error.
+    bool progressSummary(int days, ProgressSummary& summary) {
+        TRACK_LATENCY("Database::progressSummary");
+        summary = ProgressSummary();
+        bool snapshot = sqlite3_get_autocommit(db) && execute("BEGIN;");
+        bool ok = readProgress(days, summary);
+        if (snapshot) {
+            execute("COMMIT;");
+        }
+        return ok;
+    }
+
+    // Keyset pagination: up to limit questions with number > after, ascending,
+    // optionally restricted to one status. The cost depends on limit, not on
+    // the size of the table.
+    vector<Question> pageAfter(long long after, int limit, optional<Status> filter = nullopt) {
+        TRACK_LATENCY("Database::pageAfter");
+        const char* sql = filter
+            ? "SELECT number, text, status FROM questions WHERE user_id = ? AND status = ? AND number > ? "
+              "ORDER BY number LIMIT ?;"
+            : "SELECT number, text, status FROM questions WHERE user_id = ? AND number > ? ORDER BY number LIMIT ?;";
+        return fetchPage(sql, after, limit, filter);
+    }
+
+    // Up to limit questions with number < before, returned in ascending order.
+    vector<Question> pageBefore(long long before, int limit, optional<Status> filter = nullopt) {
+        TRACK_LATENCY("Database::pageBefore");
+        const char* sql = filter
+            ? "SELECT number, text, status FROM questions WHERE user_id = ? AND status = ? AND number < ? "
+              "ORDER BY number DESC LIMIT ?;"
+            : "SELECT number, text, status FROM questions WHERE user_id = ? AND number < ? "
+              "ORDER BY number DESC LIMIT ?;";
+        vector<Question> page = fetchPage(sql, before, limit, filter);
+        reverse(page.begin(), page.end());
+        return page;
+    }
+
+    // The review queue's earliest-due questions, overdue ones first, read in
+    // order from the questions_due index; questions not in the queue are not
+    // in the index, so this never scans them.
+    vector<Question> nextDue(int limit) {
+        TRACK_LATENCY("Database::nextDue");
+        vector<Question> due;
+        const char* sql = "SELECT number, text, status, due, interval_days FROM questions "
+                          "WHERE user_id = ? AND due IS NOT NULL ORDER BY due, number LIMIT ?;";
+        sqlite3_stmt* stmt = acquire(sql);
+        if (!stmt) {
+            return due;
+        }
+        StatementReset reset{stmt};
+        sqlite3_bind_int64(stmt, 1, userId);
+        sqlite3_bind_int(stmt, 2, limit);
+        streamRows(stmt, [&](const Question& question) {
+            due.push_back(question);
+            return true;
+        });
+        return due;
+    }
+
+    // Full-text search over question text through the questions_fts index.
+    // Each word in the query must match (as a prefix); results are ranked by bm25.
+    vector<Question> searchText(const string& query, int limit) {
+        vector<Question> results;
+        searchText(query, limit, results, nullptr);
+        return results;
+    }
+
+    // Same as above, but polls cancelled() while SQLite works and abandons the
+    // query as soon as it returns true. Returns false if the search was cancelled.
+    bool searchText(const string& query, int limit, vector<Question>& results, const function<bool()>& cancelled) {
+        TRACK_LATENCY("Database::searchText");
+        results.clear();
+        string match = toMatchExpression(query);
+        if (match.empty()) {
+            return true;
+        }
+        const char* sql = "SELECT q.number, q.text, q.status FROM questions_fts "
+                          "JOIN questions q ON q.user_id = ?1 AND q.number = questions_fts.rowid - (?1 << 32) "
+                          "WHERE questions_fts MATCH ?2 "
+                          "AND questions_fts.rowid BETWEEN (?1 << 32) - 2147483648 AND (?1 << 32) + 2147483647 "
+                          "ORDER BY rank LIMIT ?3;";
+        sqlite3_stmt* stmt = acquire(sql);
+        if (!stmt) {
+            return true;
+        }
+        StatementReset reset{stmt};
+        sqlite3_bind_int64(stmt, 1, userId);
+        sqlite3_bind_text(stmt, 2, match.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int(stmt, 3, limit);
+        if (cancelled) {
+            sqlite3_progress_handler(db, 1000, [](void* check) -> int {
+                return (*static_cast<const function<bool()>*>(check))() ? 1 : 0;
+            }, const_cast<function<bool()>*>(&cancelled));
+        }
+        int rc = streamRows(stmt, [&](const Question& question) {
+            results.push_back(question);
+            return true;
+        });
+        if (cancelled) {
+            sqlite3_progress_handler(db, 0, nullptr, nullptr);
+        }
+        if (rc == SQLITE_INTERRUPT) {
+            results.clear();
+            return false;
+        }
+        return true;
+    }
+
+    // A question moved into a review status joins the review queue, due now;
+    // one moved to Submitted leaves it. Moves between review statuses keep the
+    // schedule.
+    bool updateQuestionInDB(int questionNumber, Status newStatus) {
+        TRACK_LATENCY("Database::updateQuestionInDB");
+        const char* sql = "UPDATE questions SET status = ?1, "
+                          "due = CASE WHEN ?1 IN " REVIEW_STATUSES " THEN coalesce(due, strftime('%s', 'now')) END, "
+                          "interval_days = CASE WHEN ?1 IN " REVIEW_STATUSES " THEN interval_days ELSE 0 END "
+                          "WHERE user_id = ?2 AND number = ?3;";
+        sqlite3_stmt* stmt = acquire(sql);
+        if (!stmt || !joinBatch()) {
+            return false;
+        }
+        StatementReset reset{stmt};
+        sqlite3_bind_int(stmt, 1, static_cast<int>(newStatus));
+        sqlite3_bind_int64(stmt, 2, userId);
+        sqlite3_bind_int(stmt, 3, questionNumber);
+        return noteWrite(step(stmt) == SQLITE_DONE);
+    }
+
+    // Records a review: the question's new status and when it is next due, in
+    // days apart from the previous review. A due of 0 takes it out of the queue.
+    bool scheduleReview(int questionNumber, Status newStatus, long long due, int interval) {
+        TRACK_LATENCY("Database::scheduleReview");
+        const char* sql = "UPDATE questions SET status = ?, due = ?, interval_days = ? WHERE user_id = ? AND number = ?;";
+        sqlite3_stmt* stmt = acquire(sql);
+        if (!stmt || !joinBatch()) {
+            return false;
+        }
+        StatementReset reset{stmt};
+        sqlite3_bind_int(stmt, 1, static_cast<int>(newStatus));
+        if (due > 0) {
+            sqlite3_bind_int64(stmt, 2, due);
+        }
+        sqlite3_bind_int(stmt, 3, interval);
+        sqlite3_bind_int64(stmt, 4, userId);
+        sqlite3_bind_int(stmt, 5, questionNumber);
+        return noteWrite(step(stmt) == SQLITE_DONE);
+    }
+
+    bool deleteQuestionFromDB(int questionNumber) {
+        TRACK_LATENCY("Database::deleteQuestionFromDB");
+        const char* sql = "DELETE FROM questions WHERE user_id = ? AND number = ?;";
+        sqlite3_stmt* stmt = acquire(sql);
+        if (!stmt || !joinBatch()) {
+            return false;
+        }
+        StatementReset reset{stmt};
+        sqlite3_bind_int64(stmt, 1, userId);
+        sqlite3_bind_int(stmt, 2, questionNumber);
+        return noteWrite(step(stmt) == SQLITE_DONE);
+    }
+
+    bool deleteAllQuestionsFromDB() {
+        TRACK_LATENCY("Database::deleteAllQuestionsFromDB");
+        sqlite3_stmt* stmt = acquire("DELETE FROM questions WHERE user_id = ?;");
+        if (!stmt || !joinBatch()) {
+            return false;
+        }
+        StatementReset reset{stmt};
+        sqlite3_bind_int64(stmt, 1, userId);
+        return noteWrite(step(stmt) == SQLITE_DONE);
+    }
+
+    // Replaces the tags of a question with the given ones, which should come
+    // from parseTagList(). Tags not used before are created. Tagging a missing
+    // question changes nothing.
+    bool setQuestionTags(int questionNumber, const vector<string>& tags) {
+        TRACK_LATENCY("Database::setQuestionTags");
+        // The tags travel as one JSON array, bound as ?2
+        string names = "[";
+        for (const string& tag : tags) {
+            names += (names.size() > 1 ? ",\"" : "\"") + tag + "\""; // parseTag() admits nothing to escape
+        }
+        names += "]";
+        const char* statements[] = {
+            "INSERT OR IGNORE INTO tags (user_id, name) SELECT ?1, value FROM json_each(?2) "
+            "WHERE EXISTS (SELECT 1 FROM questions WHERE user_id = ?1 AND number = ?3);",
+            "DELETE FROM question_tags WHERE user_id = ?1 AND number = ?3 AND tag_id NOT IN "
+            "(SELECT t.id FROM json_each(?2) j JOIN tags t ON t.user_id = ?1 AND t.name = j.value);",
+            "INSERT OR IGNORE INTO question_tags (user_id, number, tag_id) "
+            "SELECT ?1, ?3, t.id FROM json_each(?2) j JOIN tags t ON t.user_id = ?1 AND t.name = j.value "
+            "WHERE EXISTS (SELECT 1 FROM questions WHERE user_id = ?1 AND number = ?3);",
+        };
+        if (!joinBatch() || !execute("SAVEPOINT set_tags;")) {
+            return false;
+        }
+        bool ok = true;
+        for (const char* sql : statements) {
+            sqlite3_stmt* stmt = acquire(sql);
+            if (!stmt) {
+                ok = false;
+                break;
+            }
+            StatementReset reset{stmt};
+            sqlite3_bind_int64(stmt, 1, userId);
+            sqlite3_bind_text(stmt, 2, names.c_str(), static_cast<int>(names.size()), SQLITE_STATIC);
+            sqlite3_bind_int(stmt, 3, questionNumber);
+            if (step(stmt) != SQLITE_DONE) {
+                ok = false;
+                break;
+            }
+        }
+        if (!ok) {
+            execute("ROLLBACK TO set_tags; RELEASE set_tags;");
+            return noteWrite(false);
+        }
+        return noteWrite(execute("RELEASE set_tags;"));
+    }
+
+    // Tags of one question, in name order. Empty if it has none or on a
+    // database error; lastError() tells the two apart.
+    vector<string> questionTags(int questionNumber) {
+        TRACK_LATENCY("Database::questionTags");
+        vector<string> tags;
+        const char* sql = "SELECT t.name FROM question_tags qt JOIN tags t ON t.id = qt.tag_id "
+                          "WHERE qt.user_id = ? AND qt.number = ? ORDER BY t.name;";
+        sqlite3_stmt* stmt = acquire(sql);
+        if (!stmt) {
+            return tags;
+        }
+        StatementReset reset{stmt};
+        sqlite3_bind_int64(stmt, 1, userId);
+        sqlite3_bind_int(stmt, 2, questionNumber);
+        while (step(stmt) == SQLITE_ROW) {
+            tags.emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
+        }
+        return tags;
+    }
+
+    // Every tag in use with its number of questions, in name order.
+    vector<pair<string, long long>> tagCounts() {
+        TRACK_LATENCY("Database::tagCounts");
+        vector<pair<string, long long>> counts;
+        const char* sql = "SELECT t.name, count(*) FROM question_tags qt JOIN tags t ON t.id = qt.tag_id "
+                          "WHERE qt.user_id = ? GROUP BY qt.tag_id ORDER BY t.name;";
+        sqlite3_stmt* stmt = acquire(sql);
+        if (!stmt) {
+            return counts;
+        }
+        StatementReset reset{stmt};
+        sqlite3_bind_int64(stmt, 1, userId);
+        while (step(stmt) == SQLITE_ROW) {
+            counts.emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)),
+                                sqlite3_column_int64(stmt, 1));
+        }
+        return counts;
+    }
+
+    // Streams every (tag, question number) pair, one tag after another and
+    // each tag's questions in ascending number order. The tag name is only
+    // valid during the call. Returns false on a database error.
+    bool forEachTagging(const function<void(string_view tag, int number)>& visit) {
+        TRACK_LATENCY("Database::forEachTagging");
+        const char* sql = "SELECT t.name, qt.number FROM question_tags qt JOIN tags t ON t.id = qt.tag_id "
+                          "WHERE qt.user_id = ? ORDER BY qt.tag_id, qt.number;";
+        sqlite3_stmt* stmt = acquire(sql);
+        if (!stmt) {
+            return false;
+        }
+        StatementReset reset{stmt};
+        sqlite3_bind_int64(stmt, 1, userId);
+        int rc;
+        while ((rc = step(stmt)) == SQLITE_ROW) {
+            const char* tag = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+            visit(string_view(tag, sqlite3_column_bytes(stmt, 0)), sqlite3_column_int(stmt, 1));
+        }
+        return rc == SQLITE_DONE;
+    }
+
+    // True while a group-commit transaction holds uncommitted writes.
+    bool inBatch() const {
+        return batchOpen;
+    }
+
+    // Time until the open batch must be committed; zero or less means now.
+    chrono::milliseconds batchTimeLeft() const {
+        auto deadline = batchStarted + chrono::milliseconds(options.groupCommitWindowMs);
+        return chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now());
+    }
+
+    // Commits the open batch, if any. Returns false if the commit failed, in
+    // which case every write in the batch was rolled back.
+    bool flush() {
+        TRACK_LATENCY("Database::flush");
+        if (!batchOpen) {
+            return true;
+        }
+        batchOpen = false;
+        lastFlushOk = execute("COMMIT;");
+        if (!lastFlushOk) {
+            rollbackIfOpen();
+        }
+        return lastFlushOk;
+    }
+
+    // Whether the most recent batch commit succeeded.
+    bool lastFlushSucceeded() const {
+        return lastFlushOk;
+    }
+
+    // Changes whenever another connection commits to the database file.
+    // Commits made through this connection leave it untouched.
+    long long dataVersion() {
+        TRACK_LATENCY("Database::dataVersion");
+        const char* sql = "PRAGMA data_version;";
+        sqlite3_stmt* stmt = acquire(sql);
+        if (!stmt) {
+            return -1;
+        }
+        StatementReset reset{stmt};
+        if (step(stmt) == SQLITE_ROW) {
+            return sqlite3_column_int64(stmt, 0);
+        }
+        return -1;
     }
 
     bool userExists() {
+        TRACK_LATENCY("Database::userExists");
         const char* sql = "SELECT COUNT(*) FROM users;";
-        sqlite3_stmt* stmt;
-        sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+        sqlite3_stmt* stmt = acquire(sql);
+        if (!stmt) {
+            return false;
+        }
+        StatementReset reset{stmt};
         int count = 0;
-        if (sqlite3_step(stmt) == SQLITE_ROW) {
+        if (step(stmt) == SQLITE_ROW) {
             count = sqlite3_column_int(stmt, 0);
         }
-        sqlite3_finalize(stmt);
         return count > 0;
     }
 
     bool createUser(const string& username, const string& password) {
+        TRACK_LATENCY("Database::createUser");
         // Create SHA-256 hash of password
         unsigned char hash[SHA256_DIGEST_LENGTH];
         SHA256_CTX sha256;
@@ -122,23 +832,88 @@ public:
         }
         string hashedPassword = ss.str();
         const char* sql = "INSERT INTO users (username, password) VALUES (?, ?);";
-        sqlite3_stmt* stmt;
-        sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+        sqlite3_stmt* stmt = acquire(sql);
+        if (!stmt) {
+            return false;
+        }
+        StatementReset reset{stmt};
         sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
         sqlite3_bind_text(stmt, 2, hashedPassword.c_str(), -1, SQLITE_STATIC);
-        int result = sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
+        int result = step(stmt);
         return result == SQLITE_DONE;
     }
 
     bool authenticateUser(const string& username, const string& password) {
-        const char* sql = "SELECT password FROM users WHERE username = ?;";
-        sqlite3_stmt* stmt;
-        sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+        TRACK_LATENCY("Database::authenticateUser");
+        return verifyUser(username, password) != 0;
+    }
+
+    // Checks the credentials and, if they match, scopes this connection to
+    // that user's questions.
+    bool signIn(const string& username, const string& password) {
+        TRACK_LATENCY("Database::signIn");
+        long long id = verifyUser(username, password);
+        if (id == 0) {
+            return false;
+        }
+        setUser(id);
+        return true;
+    }
+
+    // Removes the user together with their questions, tags and status history.
+    bool deleteUser(const string& username, const string& password) {
+        TRACK_LATENCY("Database::deleteUser");
+        // First authenticate the user
+        long long id = verifyUser(username, password);
+        if (id == 0) {
+            return false;
+        }
+
+        const char* statements[] = {
+            "DELETE FROM questions WHERE user_id = ?;",
+            "DELETE FROM status_events WHERE user_id = ?;",
+            "DELETE FROM status_daily WHERE user_id = ?;",
+            "DELETE FROM status_totals WHERE user_id = ?;",
+            "DELETE FROM tags WHERE user_id = ?;",
+            "DELETE FROM users WHERE id = ?;",
+        };
+        if (!execute("SAVEPOINT delete_user;")) {
+            return false;
+        }
+        bool ok = true;
+        for (const char* sql : statements) {
+            sqlite3_stmt* stmt = acquire(sql);
+            if (!stmt) {
+                ok = false;
+                break;
+            }
+            StatementReset reset{stmt};
+            sqlite3_bind_int64(stmt, 1, id);
+            if (step(stmt) != SQLITE_DONE) {
+                ok = false;
+                break;
+            }
+        }
+        if (!ok) {
+            execute("ROLLBACK TO delete_user; RELEASE delete_user;");
+            return false;
+        }
+        return execute("RELEASE delete_user;");
+    }
+
+private:
+    // The id of the user if the password matches, otherwise 0.
+    long long verifyUser(const string& username, const string& password) {
+        const char* sql = "SELECT id, password FROM users WHERE username = ?;";
+        sqlite3_stmt* stmt = acquire(sql);
+        if (!stmt) {
+            return 0;
+        }
+        StatementReset reset{stmt};
         sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
-        bool authenticated = false;
-        if (sqlite3_step(stmt) == SQLITE_ROW) {
-            const char* storedHash = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        long long id = 0;
+        if (step(stmt) == SQLITE_ROW) {
+            const char* storedHash = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
             // Hash input password and compare with stored hash
             unsigned char hash[SHA256_DIGEST_LENGTH];
             SHA256_CTX sha256;
@@ -152,27 +927,766 @@ public:
                 ss << std::hex << std::setw(2) << std::setfill('0') << (int)hash[i];
             }
             string inputHash = ss.str();
-            authenticated = (inputHash == storedHash);
+            if (inputHash == storedHash) {
+                id = sqlite3_column_int64(stmt, 0);
+            }
         }
-        sqlite3_finalize(stmt);
-        return authenticated;
+        return id;
     }
 
-    bool deleteUser(const string& username, const string& password) {
-        // First authenticate the user
-        if (!authenticateUser(username, password)) {
+    sqlite3* db;
+    StatementCache statements; // Prepared once per connection, reused on every call
+    DatabaseOptions options;
+    bool batchOpen = false;    // Group-commit transaction in progress
+    bool stagingReady = false; // Temporary import_staging table exists
+    bool lastFlushOk = true;
+    size_t batchWrites = 0;
+    chrono::steady_clock::time_point batchStarted;
+    int errorCode = SQLITE_OK;
+    string errorMessage;
+    size_t busyWaitCount = 0;
+    long long busyWaitTotalMs = 0;
+    long long busyWaitedMs = 0; // Slept so far for the current lock
+    long long userId = 0;       // users.id every question query is scoped to
+
+    // Busy handler: sleeps 1 ms, then twice as long each retry up to 100 ms,
+    // with jitter so competing processes do not retry in lockstep. Gives up
+    // (SQLITE_BUSY) once busyTimeoutMs has been spent on the same lock.
+    static int backoff(void* self, int attempt) {
+        Database& database = *static_cast<Database*>(self);
+        if (attempt == 0) {
+            database.busyWaitedMs = 0;
+            database.busyWaitCount++;
+        }
+        if (database.busyWaitedMs >= database.options.busyTimeoutMs) {
+            return 0;
+        }
+        thread_local minstd_rand jitter(random_device{}());
+        long long delay = min(100LL, 1LL << min(attempt, 7));
+        delay = min(delay / 2 + static_cast<long long>(jitter() % (delay / 2 + 1)),
+                    database.options.busyTimeoutMs - database.busyWaitedMs);
+        this_thread::sleep_for(chrono::milliseconds(delay));
+        database.busyWaitedMs += delay;
+        database.busyWaitTotalMs += delay;
+        return 1;
+    }
+
+    // Steps a statement and records the outcome for lastError(). Anything other
+    // than a row or completion is also logged.
+    int step(sqlite3_stmt* stmt) {
+        int rc = sqlite3_step(stmt);
+        if (rc == SQLITE_ROW || rc == SQLITE_DONE) {
+            errorCode = SQLITE_OK;
+        } else {
+            noteError(rc);
+        }
+        return rc;
+    }
+
+    sqlite3_stmt* acquire(const char* sql) {
+        sqlite3_stmt* stmt = statements.acquire(sql);
+        if (!stmt) {
+            noteError(sqlite3_errcode(db));
+        }
+        return stmt;
+    }
+
+    void noteError(int rc) {
+        errorCode = rc;
+        errorMessage = sqlite3_errmsg(db);
+        if (rc != SQLITE_INTERRUPT && options.logErrors) {
+            cerr << "SQL error: " << errorMessage << endl;
+        }
+    }
+
+    void configure() {
+        // Only whitelisted values are spliced into the PRAGMA
+        const char* levels[] = {"OFF", "NORMAL", "FULL", "EXTRA"};
+        string synchronous = "NORMAL";
+        for (const char* level : levels) {
+            if (options.synchronous == level) {
+                synchronous = level;
+            }
+        }
+        execute(options.wal ? "PRAGMA journal_mode = WAL;" : "PRAGMA journal_mode = DELETE;");
+        execute(("PRAGMA synchronous = " + synchronous + ";").c_str());
+    }
+
+    // Opens a group-commit transaction before a write if group commit is on.
+    bool joinBatch() {
+        if (options.groupCommitOps <= 1 || batchOpen) {
+            return true;
+        }
+        return openBatch();
+    }
+
+    bool openBatch() {
+        if (!execute("BEGIN IMMEDIATE;")) {
             return false;
         }
-        
-        const char* sql = "DELETE FROM users WHERE username = ?;";
-        sqlite3_stmt* stmt;
-        sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-        sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
-        int result = sqlite3_step(stmt);
+        batchOpen = true;
+        batchWrites = 0;
+        batchStarted = chrono::steady_clock::now();
+        return true;
+    }
+
+    // Counts a write against the open batch and commits it once it is full or
+    // its window has passed. Returns the write's result, or false if the commit
+    // that followed it failed.
+    bool noteWrite(bool ok) {
+        if (!batchOpen) {
+            return ok;
+        }
+        batchWrites++;
+        if (batchWrites >= options.groupCommitOps || batchTimeLeft().count() <= 0) {
+            return flush() && ok;
+        }
+        return ok;
+    }
+
+    bool execute(const char* sql) {
+        char* errMsg;
+        int rc = sqlite3_exec(db, sql, nullptr, 0, &errMsg);
+        if (rc != SQLITE_OK) {
+            if (options.logErrors) {
+                cerr << "SQL error: " << errMsg << endl;
+            }
+            errorCode = rc;
+            errorMessage = errMsg;
+            sqlite3_free(errMsg);
+            return false;
+        }
+        errorCode = SQLITE_OK;
+        return true;
+    }
+
+    // Reads a status column into status. Returns false for a value outside
+    // the Status enum, which a hand-edited file or another program may have
+    // stored; callers skip such rows, as Status values index per-status arrays.
+    static bool readStatus(sqlite3_stmt* stmt, int column, Status& status) {
+        int value = sqlite3_column_int(stmt, column);
+        if (value < 0 || value >= static_cast<int>(STATUS_COUNT)) {
+            return false;
+        }
+        status = static_cast<Status>(value);
+        return true;
+    }
+
+    // Steps a SELECT of (number, text, status), optionally followed by (due,
+    // interval_days), and hands each row to the visitor.
+    // Returns the last step result: SQLITE_ROW if the visitor stopped early,
+    // SQLITE_DONE at the end, or the error code.
+    int streamRows(sqlite3_stmt* stmt, const function<bool(const Question&)>& visit) {
+        Question question;
+        bool scheduled = sqlite3_column_count(stmt) >= 5; // Also selects due, interval_days
+        int rc;
+        while ((rc = step(stmt)) == SQLITE_ROW) {
+            question.number = sqlite3_column_int(stmt, 0);
+            question.text.assign(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)),
+                                 sqlite3_column_bytes(stmt, 1));
+            if (!readStatus(stmt, 2, question.status)) {
+                continue; // Not a status this program knows, see readStatus()
+            }
+            if (scheduled) {
+                question.due = sqlite3_column_int64(stmt, 3); // NULL reads as 0
+                question.interval = sqlite3_column_int(stmt, 4);
+            }
+            if (!visit(question)) {
+                break;
+            }
+        }
+        return rc;
+    }
+
+    // Whether a streamRows result means the rows were read without error.
+    static bool finished(int rc) {
+        return rc == SQLITE_ROW || rc == SQLITE_DONE;
+    }
+
+    bool readProgress(int days, ProgressSummary& summary) {
+        sqlite3_stmt* stmt = acquire("SELECT " LOCAL_DAY("strftime('%s', 'now')") ", "
+                                     "(SELECT min(day) FROM status_daily WHERE user_id = ?);");
+        if (!stmt) {
+            return false;
+        }
+        {
+            StatementReset reset{stmt};
+            sqlite3_bind_int64(stmt, 1, userId);
+            if (step(stmt) != SQLITE_ROW) {
+                return false;
+            }
+            summary.today = sqlite3_column_int64(stmt, 0);
+            if (sqlite3_column_type(stmt, 1) != SQLITE_NULL) {
+                summary.firstDay = sqlite3_column_int64(stmt, 1);
+            }
+        }
+        stmt = acquire("SELECT day, status, entered, left FROM status_daily "
+                       "WHERE user_id = ? AND day >= ? ORDER BY day;");
+        if (!stmt) {
+            return false;
+        }
+        {
+            StatementReset reset{stmt};
+            sqlite3_bind_int64(stmt, 1, userId);
+            sqlite3_bind_int64(stmt, 2, summary.today - days + 1);
+            int rc;
+            while ((rc = step(stmt)) == SQLITE_ROW) {
+                long long day = sqlite3_column_int64(stmt, 0);
+                size_t status = static_cast<size_t>(sqlite3_column_int(stmt, 1));
+                if (summary.days.empty() || summary.days.back().day != day) {
+                    summary.days.push_back(StatusMoves());
+                    summary.days.back().day = day;
+                }
+                if (status < STATUS_COUNT) {
+                    summary.days.back().entered[status] = sqlite3_column_int64(stmt, 2);
+                    summary.days.back().left[status] = sqlite3_column_int64(stmt, 3);
+                }
+            }
+            if (rc != SQLITE_DONE) {
+                return false;
+            }
+        }
+        stmt = acquire("SELECT status, entered, left FROM status_totals WHERE user_id = ?;");
+        if (!stmt) {
+            return false;
+        }
+        StatementReset reset{stmt};
+        sqlite3_bind_int64(stmt, 1, userId);
+        int rc;
+        while ((rc = step(stmt)) == SQLITE_ROW) {
+            size_t status = static_cast<size_t>(sqlite3_column_int(stmt, 0));
+            if (status < STATUS_COUNT) {
+                summary.total.entered[status] = sqlite3_column_int64(stmt, 1);
+                summary.total.left[status] = sqlite3_column_int64(stmt, 2);
+            }
+        }
+        return rc == SQLITE_DONE;
+    }
+
+    bool replayChanges(long long& sequence,
+                       const function<void(int number, const Question* question, const vector<string>& tags)>& visit) {
+        sqlite3_stmt* stmt = acquire("SELECT min(seq), max(seq) FROM question_changes;");
+        if (!stmt) {
+            return false;
+        }
+        long long oldest = 0, newest = 0;
+        {
+            StatementReset reset{stmt};
+            if (step(stmt) != SQLITE_ROW) {
+                return false;
+            }
+            oldest = sqlite3_column_int64(stmt, 0);
+            newest = sqlite3_column_int64(stmt, 1);
+        }
+        if (newest < sequence) {
+            return false; // The log never reached that far: a different or recreated database
+        }
+        if (newest == sequence) {
+            return true; // No question changed since then, e.g. only users did
+        }
+        if (oldest > sequence + 1) {
+            return false; // Entries after sequence were already pruned
+        }
+        // Latest state of every question of this user touched since; a missing
+        // row was deleted. Other users' entries only advance the sequence.
+        stmt = acquire("SELECT c.number, q.text, q.status, q.due, q.interval_days, "
+                       "(SELECT group_concat(t.name) FROM question_tags qt JOIN tags t ON t.id = qt.tag_id "
+                       "WHERE qt.user_id = ?1 AND qt.number = c.number) FROM "
+                       "(SELECT DISTINCT number FROM question_changes WHERE seq > ?2 AND user_id = ?1) c "
+                       "LEFT JOIN questions q ON q.user_id = ?1 AND q.number = c.number;");
+        if (!stmt) {
+            return false;
+        }
+        StatementReset reset{stmt};
+        sqlite3_bind_int64(stmt, 1, userId);
+        sqlite3_bind_int64(stmt, 2, sequence);
+        Question question;
+        vector<string> tags;
+        int rc;
+        while ((rc = step(stmt)) == SQLITE_ROW) {
+            int number = sqlite3_column_int(stmt, 0);
+            tags.clear();
+            // A row whose status cannot be read is left out, as loads leave it out
+            if (sqlite3_column_type(stmt, 1) == SQLITE_NULL || !readStatus(stmt, 2, question.status)) {
+                visit(number, nullptr, tags);
+                continue;
+            }
+            question.number = number;
+            question.text.assign(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)),
+                                 sqlite3_column_bytes(stmt, 1));
+            question.due = sqlite3_column_int64(stmt, 3);
+            question.interval = sqlite3_column_int(stmt, 4);
+            // Tag names never contain a comma, see parseTag()
+            string_view names(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5)), sqlite3_column_bytes(stmt, 5));
+            while (!names.empty()) {
+                size_t comma = min(names.find(','), names.size());
+                tags.emplace_back(names.substr(0, comma));
+                names.remove_prefix(min(comma + 1, names.size()));
+            }
+            sort(tags.begin(), tags.end());
+            visit(number, &question, tags);
+        }
+        if (rc != SQLITE_DONE) {
+            return false;
+        }
+        sequence = newest;
+        return true;
+    }
+
+    void rollbackIfOpen() {
+        if (!sqlite3_get_autocommit(db)) {
+            execute("ROLLBACK;");
+        }
+    }
+
+    // Turns free text into an FTS5 query: every word becomes a quoted prefix
+    // term, so user input can never be parsed as FTS5 operators.
+    static string toMatchExpression(const string& query) {
+        string match;
+        string word;
+        for (size_t i = 0; i <= query.size(); ++i) {
+            unsigned char c = i < query.size() ? query[i] : ' ';
+            if (isalnum(c) || c >= 0x80) {
+                word += static_cast<char>(c);
+            } else if (!word.empty()) {
+                match += (match.empty() ? "\"" : " \"") + word + "\"*";
+                word.clear();
+            }
+        }
+        return match;
+    }
+
+    // Binds an optional status, the keyset bound and the limit, in that order.
+    vector<Question> fetchPage(const char* sql, long long key, int limit, optional<Status> filter) {
+        vector<Question> page;
+        sqlite3_stmt* stmt = acquire(sql);
+        if (!stmt) {
+            return page;
+        }
+        StatementReset reset{stmt};
+        sqlite3_bind_int64(stmt, 1, userId);
+        int param = 2;
+        if (filter) {
+            sqlite3_bind_int(stmt, param++, static_cast<int>(*filter));
+        }
+        sqlite3_bind_int64(stmt, param++, key);
+        sqlite3_bind_int(stmt, param, limit);
+        page.reserve(limit);
+        streamRows(stmt, [&](const Question& question) {
+            page.push_back(question);
+            return true;
+        });
+        return page;
+    }
+
+    // Schema version stored in PRAGMA user_version. Add a step to migrateSchema()
+    // and raise LATEST_SCHEMA_VERSION whenever the layout of an existing table changes.
+    static constexpr int LATEST_SCHEMA_VERSION = 8;
+
+    int schemaVersion() {
+        sqlite3_stmt* stmt = nullptr;
+        int version = 0;
+        if (sqlite3_prepare_v2(db, "PRAGMA user_version;", -1, &stmt, nullptr) == SQLITE_OK &&
+            sqlite3_step(stmt) == SQLITE_ROW) {
+            version = sqlite3_column_int(stmt, 0);
+        }
         sqlite3_finalize(stmt);
-        return result == SQLITE_DONE;
+        return version;
     }
 
-private:
-    sqlite3* db;
+    // Declared type of a column, e.g. "INTEGER", or empty if it does not exist.
+    string columnType(const char* table, const char* column) {
+        sqlite3_stmt* stmt = nullptr;
+        string type;
+        if (sqlite3_prepare_v2(db, "SELECT type FROM pragma_table_info(?) WHERE name = ?;", -1, &stmt, nullptr) == SQLITE_OK) {
+            sqlite3_bind_text(stmt, 1, table, -1, SQLITE_STATIC);
+            sqlite3_bind_text(stmt, 2, column, -1, SQLITE_STATIC);
+            if (sqlite3_step(stmt) == SQLITE_ROW) {
+                type = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+            }
+        }
+        sqlite3_finalize(stmt);
+        return type;
+    }
+
+    // Contentless FTS5 index over questions.text, kept in sync by triggers and
+    // filled from existing rows. questions has no integer rowid to point an
+    // external-content index at, so rows are keyed by FTS_ROWID and the text is
+    // read back from questions. Status updates do not touch it; only inserts,
+    // deletes and text/number/owner changes do.
+    bool createSearchIndex() {
+        return execute("CREATE VIRTUAL TABLE questions_fts USING fts5(text, content='');"
+                       "INSERT INTO questions_fts (rowid, text) SELECT " FTS_ROWID("questions") ", text FROM questions;"
+                       "CREATE TRIGGER questions_fts_insert AFTER INSERT ON questions BEGIN "
+                       "INSERT INTO questions_fts (rowid, text) VALUES (" FTS_ROWID("new") ", new.text); END;"
+                       "CREATE TRIGGER questions_fts_delete AFTER DELETE ON questions BEGIN "
+                       "INSERT INTO questions_fts (questions_fts, rowid, text) "
+                       "VALUES ('delete', " FTS_ROWID("old") ", old.text); END;"
+                       "CREATE TRIGGER questions_fts_update AFTER UPDATE OF user_id, number, text ON questions BEGIN "
+                       "INSERT INTO questions_fts (questions_fts, rowid, text) "
+                       "VALUES ('delete', " FTS_ROWID("old") ", old.text); "
+                       "INSERT INTO questions_fts (rowid, text) VALUES (" FTS_ROWID("new") ", new.text); END;");
+    }
+
+    // Append-only log of the (user, question number) pairs every commit
+    // touched, from any connection or process. Readers that saw the log up to
+    // some seq replay just their own user's numbers after it instead of
+    // reloading. Every 1024th entry trims everything more than 65536 entries
+    // old; a reader that falls that far behind reloads in full.
+    bool createChangeLog() {
+        return execute("CREATE TABLE IF NOT EXISTS question_changes ("
+                       "seq INTEGER PRIMARY KEY AUTOINCREMENT," // Never reused, even after trimming
+                       "user_id INTEGER NOT NULL,"
+                       "number INTEGER NOT NULL);"
+                       "CREATE TRIGGER IF NOT EXISTS question_changes_insert AFTER INSERT ON questions BEGIN "
+                       "INSERT INTO question_changes (user_id, number) VALUES (new.user_id, new.number); END;"
+                       "CREATE TRIGGER IF NOT EXISTS question_changes_update AFTER UPDATE ON questions BEGIN "
+                       "INSERT INTO question_changes (user_id, number) VALUES (old.user_id, old.number); "
+                       "INSERT INTO question_changes (user_id, number) SELECT new.user_id, new.number "
+                       "WHERE new.user_id <> old.user_id OR new.number <> old.number; END;"
+                       "CREATE TRIGGER IF NOT EXISTS question_changes_delete AFTER DELETE ON questions BEGIN "
+                       "INSERT INTO question_changes (user_id, number) VALUES (old.user_id, old.number); END;"
+                       "CREATE TRIGGER IF NOT EXISTS question_changes_trim AFTER INSERT ON question_changes "
+                       "WHEN new.seq % 1024 = 0 BEGIN "
+                       "DELETE FROM question_changes WHERE seq <= new.seq - 65536; END;");
+    }
+
+    // Append-only history of status moves, one event per added question, status
+    // change or deletion, written by triggers in the same transaction as the
+    // change itself. Each event is also counted into status_daily (per user,
+    // local day and status) and status_totals (per user and status), so
+    // dashboards read a few summary rows instead of scanning the history.
+    bool createStatusHistory() {
+        return execute("CREATE TABLE IF NOT EXISTS status_events ("
+                       "id INTEGER PRIMARY KEY,"
+                       "user_id INTEGER NOT NULL,"
+                       "number INTEGER NOT NULL,"
+                       "from_status INTEGER," // NULL when the question was added
+                       "to_status INTEGER,"   // NULL when it was deleted
+                       "at INTEGER NOT NULL);" // Unix time in seconds
+                       "CREATE TABLE IF NOT EXISTS status_daily ("
+                       "user_id INTEGER NOT NULL,"
+                       "day INTEGER NOT NULL," // Days since 1970-01-01 in local time
+                       "status INTEGER NOT NULL,"
+                       "entered INTEGER NOT NULL DEFAULT 0,"
+                       "left INTEGER NOT NULL DEFAULT 0,"
+                       "PRIMARY KEY (user_id, day, status)) WITHOUT ROWID;"
+                       "CREATE TABLE IF NOT EXISTS status_totals ("
+                       "user_id INTEGER NOT NULL,"
+                       "status INTEGER NOT NULL,"
+                       "entered INTEGER NOT NULL DEFAULT 0,"
+                       "left INTEGER NOT NULL DEFAULT 0,"
+                       "PRIMARY KEY (user_id, status)) WITHOUT ROWID;"
+                       "CREATE TRIGGER IF NOT EXISTS status_events_insert AFTER INSERT ON questions BEGIN "
+                       "INSERT INTO status_events (user_id, number, from_status, to_status, at) "
+                       "VALUES (new.user_id, new.number, NULL, new.status, strftime('%s', 'now')); END;"
+                       "CREATE TRIGGER IF NOT EXISTS status_events_update AFTER UPDATE OF status ON questions "
+                       "WHEN old.status <> new.status BEGIN "
+                       "INSERT INTO status_events (user_id, number, from_status, to_status, at) "
+                       "VALUES (new.user_id, new.number, old.status, new.status, strftime('%s', 'now')); END;"
+                       "CREATE TRIGGER IF NOT EXISTS status_events_delete AFTER DELETE ON questions BEGIN "
+                       "INSERT INTO status_events (user_id, number, from_status, to_status, at) "
+                       "VALUES (old.user_id, old.number, old.status, NULL, strftime('%s', 'now')); END;"
+                       "CREATE TRIGGER IF NOT EXISTS status_events_count AFTER INSERT ON status_events BEGIN "
+                       "INSERT INTO status_daily (user_id, day, status, entered) "
+                       "SELECT new.user_id, " LOCAL_DAY("new.at") ", new.to_status, 1 WHERE new.to_status IS NOT NULL "
+                       "ON CONFLICT (user_id, day, status) DO UPDATE SET entered = entered + 1;"
+                       "INSERT INTO status_daily (user_id, day, status, left) "
+                       "SELECT new.user_id, " LOCAL_DAY("new.at") ", new.from_status, 1 WHERE new.from_status IS NOT NULL "
+                       "ON CONFLICT (user_id, day, status) DO UPDATE SET left = left + 1;"
+                       "INSERT INTO status_totals (user_id, status, entered) "
+                       "SELECT new.user_id, new.to_status, 1 WHERE new.to_status IS NOT NULL "
+                       "ON CONFLICT (user_id, status) DO UPDATE SET entered = entered + 1;"
+                       "INSERT INTO status_totals (user_id, status, left) "
+                       "SELECT new.user_id, new.from_status, 1 WHERE new.from_status IS NOT NULL "
+                       "ON CONFLICT (user_id, status) DO UPDATE SET left = left + 1; END;");
+    }
+
+    // Each user's tag names, and which questions carry which tags. Deleting a
+    // question drops its tags. Tagging and untagging go into the change log
+    // like any other change to the question, except the untagging that
+    // follows a question's own deletion.
+    bool createTags() {
+        return execute("CREATE TABLE IF NOT EXISTS tags ("
+                       "id INTEGER PRIMARY KEY,"
+                       "user_id INTEGER NOT NULL,"
+                       "name TEXT NOT NULL," // As parseTag() normalizes it
+                       "UNIQUE (user_id, name));"
+                       "CREATE TABLE IF NOT EXISTS question_tags ("
+                       "user_id INTEGER NOT NULL,"
+                       "number INTEGER NOT NULL,"
+                       "tag_id INTEGER NOT NULL," // tags.id
+                       "PRIMARY KEY (user_id, number, tag_id)) WITHOUT ROWID;"
+                       // In (user_id, tag_id, number) order, for loading one tag at a time
+                       "CREATE INDEX IF NOT EXISTS question_tags_tag ON question_tags(user_id, tag_id);"
+                       "CREATE TRIGGER IF NOT EXISTS question_tags_delete AFTER DELETE ON questions BEGIN "
+                       "DELETE FROM question_tags WHERE user_id = old.user_id AND number = old.number; END;"
+                       "CREATE TRIGGER IF NOT EXISTS question_tags_changes_insert AFTER INSERT ON question_tags BEGIN "
+                       "INSERT INTO question_changes (user_id, number) VALUES (new.user_id, new.number); END;"
+                       "CREATE TRIGGER IF NOT EXISTS question_tags_changes_delete AFTER DELETE ON question_tags "
+                       "WHEN EXISTS (SELECT 1 FROM questions WHERE user_id = old.user_id AND number = old.number) BEGIN "
+                       "INSERT INTO question_changes (user_id, number) VALUES (old.user_id, old.number); END;");
+    }
+
+    // The full-text index, change log and status history as schema versions 3
+    // to 5 created them, before questions were keyed by user. Kept unchanged so
+    // older files upgrade through the steps that shipped; v6 replaces all three.
+    bool createSearchIndexV3() {
+        return execute("CREATE VIRTUAL TABLE IF NOT EXISTS questions_fts USING fts5("
+                       "text, content='questions', content_rowid='number');"
+                       "CREATE TRIGGER IF NOT EXISTS questions_fts_insert AFTER INSERT ON questions BEGIN "
+                       "INSERT INTO questions_fts (rowid, text) VALUES (new.number, new.text); END;"
+                       "CREATE TRIGGER IF NOT EXISTS questions_fts_delete AFTER DELETE ON questions BEGIN "
+                       "INSERT INTO questions_fts (questions_fts, rowid, text) VALUES ('delete', old.number, old.text); END;"
+                       "CREATE TRIGGER IF NOT EXISTS questions_fts_update AFTER UPDATE OF number, text ON questions BEGIN "
+                       "INSERT INTO questions_fts (questions_fts, rowid, text) VALUES ('delete', old.number, old.text); "
+                       "INSERT INTO questions_fts (rowid, text) VALUES (new.number, new.text); END;");
+    }
+
+    bool createChangeLogV4() {
+        return execute("CREATE TABLE IF NOT EXISTS question_changes ("
+                       "seq INTEGER PRIMARY KEY AUTOINCREMENT," // Never reused, even after trimming
+                       "number INTEGER NOT NULL);"
+                       "CREATE TRIGGER IF NOT EXISTS question_changes_insert AFTER INSERT ON questions BEGIN "
+                       "INSERT INTO question_changes (number) VALUES (new.number); END;"
+                       "CREATE TRIGGER IF NOT EXISTS question_changes_update AFTER UPDATE ON questions BEGIN "
+                       "INSERT INTO question_changes (number) VALUES (old.number); "
+                       "INSERT INTO question_changes (number) SELECT new.number WHERE new.number <> old.number; END;"
+                       "CREATE TRIGGER IF NOT EXISTS question_changes_delete AFTER DELETE ON questions BEGIN "
+                       "INSERT INTO question_changes (number) VALUES (old.number); END;"
+                       "CREATE TRIGGER IF NOT EXISTS question_changes_trim AFTER INSERT ON question_changes "
+                       "WHEN new.seq % 1024 = 0 BEGIN "
+                       "DELETE FROM question_changes WHERE seq <= new.seq - 65536; END;");
+    }
+
+    bool createStatusHistoryV5() {
+        return execute("CREATE TABLE IF NOT EXISTS status_events ("
+                       "id INTEGER PRIMARY KEY,"
+                       "number INTEGER NOT NULL,"
+                       "from_status INTEGER," // NULL when the question was added
+                       "to_status INTEGER,"   // NULL when it was deleted
+                       "at INTEGER NOT NULL);" // Unix time in seconds
+                       "CREATE TABLE IF NOT EXISTS status_daily ("
+                       "day INTEGER NOT NULL," // Days since 1970-01-01 in local time
+                       "status INTEGER NOT NULL,"
+                       "entered INTEGER NOT NULL DEFAULT 0,"
+                       "left INTEGER NOT NULL DEFAULT 0,"
+                       "PRIMARY KEY (day, status)) WITHOUT ROWID;"
+                       "CREATE TABLE IF NOT EXISTS status_totals ("
+                       "status INTEGER PRIMARY KEY,"
+                       "entered INTEGER NOT NULL DEFAULT 0,"
+                       "left INTEGER NOT NULL DEFAULT 0);"
+                       "CREATE TRIGGER IF NOT EXISTS status_events_insert AFTER INSERT ON questions BEGIN "
+                       "INSERT INTO status_events (number, from_status, to_status, at) "
+                       "VALUES (new.number, NULL, new.status, strftime('%s', 'now')); END;"
+                       "CREATE TRIGGER IF NOT EXISTS status_events_update AFTER UPDATE OF status ON questions "
+                       "WHEN old.status <> new.status BEGIN "
+                       "INSERT INTO status_events (number, from_status, to_status, at) "
+                       "VALUES (new.number, old.status, new.status, strftime('%s', 'now')); END;"
+                       "CREATE TRIGGER IF NOT EXISTS status_events_delete AFTER DELETE ON questions BEGIN "
+                       "INSERT INTO status_events (number, from_status, to_status, at) "
+                       "VALUES (old.number, old.status, NULL, strftime('%s', 'now')); END;"
+                       "CREATE TRIGGER IF NOT EXISTS status_events_count AFTER INSERT ON status_events BEGIN "
+                       "INSERT INTO status_daily (day, status, entered) "
+                       "SELECT " LOCAL_DAY("new.at") ", new.to_status, 1 WHERE new.to_status IS NOT NULL "
+                       "ON CONFLICT (day, status) DO UPDATE SET entered = entered + 1;"
+                       "INSERT INTO status_daily (day, status, left) "
+                       "SELECT " LOCAL_DAY("new.at") ", new.from_status, 1 WHERE new.from_status IS NOT NULL "
+                       "ON CONFLICT (day, status) DO UPDATE SET left = left + 1;"
+                       "INSERT INTO status_totals (status, entered) "
+                       "SELECT new.to_status, 1 WHERE new.to_status IS NOT NULL "
+                       "ON CONFLICT (status) DO UPDATE SET entered = entered + 1;"
+                       "INSERT INTO status_totals (status, left) "
+                       "SELECT new.from_status, 1 WHERE new.from_status IS NOT NULL "
+                       "ON CONFLICT (status) DO UPDATE SET left = left + 1; END;");
+    }
+
+    // Upgrades existing database files one schema version at a time, all in
+    // one transaction. The write lock is taken before the version is read, so
+    // when two processes open an old file at once the second waits, then
+    // finds it already upgraded; a failed step leaves the file as it was.
+    // Returns false if the file could not be upgraded.
+    bool migrateSchema() {
+        if (schemaVersion() >= LATEST_SCHEMA_VERSION) {
+            return true; // Versions only go up, so no lock is needed to see this
+        }
+        if (!execute("BEGIN IMMEDIATE;")) {
+            return false;
+        }
+        int version = schemaVersion();
+        if (version < 1) {
+            // v1: number TEXT PRIMARY KEY -> number INTEGER PRIMARY KEY.
+            // Rows whose number is not a plain integer are parked in
+            // questions_unmigrated rather than dropped.
+            bool ok = true;
+            if (columnType("questions", "number") != "INTEGER") {
+                ok = execute("CREATE TABLE questions_v1 ("
+                             "number INTEGER PRIMARY KEY,"
+                             "text TEXT NOT NULL,"
+                             "status TEXT NOT NULL);"
+                             "CREATE TABLE IF NOT EXISTS questions_unmigrated ("
+                             "number TEXT,"
+                             "text TEXT NOT NULL,"
+                             "status TEXT NOT NULL);"
+                             "INSERT OR IGNORE INTO questions_v1 (number, text, status) "
+                             "SELECT CAST(number AS INTEGER), text, status FROM questions "
+                             "WHERE number <> '' AND number NOT GLOB '*[^0-9]*' AND length(number) <= 9;"
+                             "INSERT INTO questions_unmigrated (number, text, status) "
+                             "SELECT number, text, status FROM questions "
+                             "WHERE NOT (number <> '' AND number NOT GLOB '*[^0-9]*' AND length(number) <= 9) "
+                             "OR NOT EXISTS (SELECT 1 FROM questions_v1 v WHERE v.number = CAST(questions.number AS INTEGER) "
+                             "AND v.text = questions.text AND v.status = questions.status);"
+                             "DROP TABLE questions;"
+                             "ALTER TABLE questions_v1 RENAME TO questions;");
+            }
+            if (!ok || !execute("PRAGMA user_version = 1;")) {
+                rollbackIfOpen();
+                return false;
+            }
+        }
+        if (version < 2) {
+            // v2: status TEXT -> status INTEGER holding the Status enum value.
+            // Unrecognised labels become Not Understood.
+            bool ok = true;
+            if (columnType("questions", "status") != "INTEGER") {
+                ok = execute("CREATE TABLE questions_v2 ("
+                             "number INTEGER PRIMARY KEY,"
+                             "text TEXT NOT NULL,"
+                             "status INTEGER NOT NULL);"
+                             "INSERT INTO questions_v2 (number, text, status) "
+                             "SELECT number, text, CASE status "
+                             "WHEN 'Submitted' THEN 0 WHEN 'Under Review' THEN 1 ELSE 2 END FROM questions;"
+                             "DROP TABLE questions;"
+                             "ALTER TABLE questions_v2 RENAME TO questions;");
+            }
+            if (!ok || !execute("PRAGMA user_version = 2;")) {
+                rollbackIfOpen();
+                return false;
+            }
+        }
+        if (version < 3) {
+            // v3: full-text index over existing rows. Triggers keep it current from here on.
+            if (!createSearchIndexV3() ||
+                !execute("INSERT INTO questions_fts (questions_fts) VALUES ('rebuild');"
+                         "PRAGMA user_version = 3;")) {
+                rollbackIfOpen();
+                return false;
+            }
+        }
+        if (version < 4) {
+            // v4: change log for incremental reloads. Existing rows need no
+            // entries; readers start from a full load.
+            if (!createChangeLogV4() || !execute("PRAGMA user_version = 4;")) {
+                rollbackIfOpen();
+                return false;
+            }
+        }
+        if (version < 5) {
+            // v5: status history. Nothing is known about moves made before
+            // the upgrade, so history starts empty.
+            if (!createStatusHistoryV5() || !execute("PRAGMA user_version = 5;")) {
+                rollbackIfOpen();
+                return false;
+            }
+        }
+        if (version < 6) {
+            // v6: questions partitioned by user. users gains an integer id and
+            // questions becomes WITHOUT ROWID keyed by (user_id, number). Rows
+            // from before the upgrade, their change log entries and their
+            // history go to the oldest user, or to the first one created.
+            // Daily and total counts are rebuilt from the copied events.
+            const char* owner = "(SELECT coalesce(min(id), 1) FROM users)";
+            bool ok = execute("DROP TRIGGER IF EXISTS questions_fts_insert;"
+                              "DROP TRIGGER IF EXISTS questions_fts_delete;"
+                              "DROP TRIGGER IF EXISTS questions_fts_update;"
+                              "DROP TRIGGER IF EXISTS question_changes_insert;"
+                              "DROP TRIGGER IF EXISTS question_changes_update;"
+                              "DROP TRIGGER IF EXISTS question_changes_delete;"
+                              "DROP TRIGGER IF EXISTS question_changes_trim;"
+                              "DROP TRIGGER IF EXISTS status_events_insert;"
+                              "DROP TRIGGER IF EXISTS status_events_update;"
+                              "DROP TRIGGER IF EXISTS status_events_delete;"
+                              "DROP TRIGGER IF EXISTS status_events_count;"
+                              "DROP TABLE IF EXISTS questions_fts;"
+                              "DROP INDEX IF EXISTS questions_status;");
+            if (ok && columnType("users", "id").empty()) {
+                ok = execute("CREATE TABLE users_v6 ("
+                             "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+                             "username TEXT NOT NULL UNIQUE,"
+                             "password TEXT NOT NULL);"
+                             "INSERT INTO users_v6 (username, password) SELECT username, password FROM users ORDER BY rowid;"
+                             "DROP TABLE users;"
+                             "ALTER TABLE users_v6 RENAME TO users;");
+            }
+            if (ok && columnType("questions", "user_id").empty()) {
+                ok = execute((string("CREATE TABLE questions_v6 ("
+                                     "user_id INTEGER NOT NULL,"
+                                     "number INTEGER NOT NULL,"
+                                     "text TEXT NOT NULL,"
+                                     "status INTEGER NOT NULL,"
+                                     "PRIMARY KEY (user_id, number)) WITHOUT ROWID;"
+                                     "INSERT INTO questions_v6 (user_id, number, text, status) SELECT ") +
+                              owner + ", number, text, status FROM questions ORDER BY number;"
+                              "DROP TABLE questions;"
+                              "ALTER TABLE questions_v6 RENAME TO questions;").c_str());
+            }
+            bool oldLog = ok && !columnType("question_changes", "seq").empty() &&
+                          columnType("question_changes", "user_id").empty();
+            if (oldLog) {
+                ok = execute("ALTER TABLE question_changes RENAME TO question_changes_v5;");
+            }
+            bool oldHistory = ok && !columnType("status_events", "id").empty() &&
+                              columnType("status_events", "user_id").empty();
+            if (oldHistory) {
+                ok = execute("ALTER TABLE status_events RENAME TO status_events_v5;"
+                             "DROP TABLE status_daily;"
+                             "DROP TABLE status_totals;");
+            }
+            ok = ok && createSearchIndex() && createChangeLog() && createStatusHistory();
+            if (ok && oldLog) {
+                // Same sequence numbers, so readers that saw the old log carry on
+                ok = execute((string("INSERT INTO question_changes (seq, user_id, number) SELECT seq, ") + owner +
+                              ", number FROM question_changes_v5 ORDER BY seq;"
+                              "DROP TABLE question_changes_v5;").c_str());
+            }
+            if (ok && oldHistory) {
+                ok = execute((string("INSERT INTO status_events (id, user_id, number, from_status, to_status, at) "
+                                     "SELECT id, ") + owner +
+                              ", number, from_status, to_status, at FROM status_events_v5 ORDER BY id;"
+                              "DROP TABLE status_events_v5;").c_str());
+            }
+            if (!ok || !execute("PRAGMA user_version = 6;")) {
+                rollbackIfOpen();
+                return false;
+            }
+        }
+        if (version < 7) {
+            // v7: review schedule. Questions already in a review status join
+            // the queue due now.
+            bool ok = true;
+            if (columnType("questions", "due").empty()) {
+                ok = execute("ALTER TABLE questions ADD COLUMN due INTEGER;"
+                             "ALTER TABLE questions ADD COLUMN interval_days INTEGER NOT NULL DEFAULT 0;"
+                             "UPDATE questions SET due = strftime('%s', 'now') WHERE status IN " REVIEW_STATUSES ";");
+            }
+            if (!ok || !execute("PRAGMA user_version = 7;")) {
+                rollbackIfOpen();
+                return false;
+            }
+        }
+        if (version < 8) {
+            // v8: tags on questions, see createTags()
+            if (!createTags() || !execute("PRAGMA user_version = 8;")) {
+                rollbackIfOpen();
+                return false;
+            }
+        }
+        if (!execute("COMMIT;")) {
+            rollbackIfOpen();
+            return false;
+        }
+        return true;
+    }
 };
+
+#endif // DATABASE_CPP
@@ -0,0 +1,222 @@
+#ifndef DB_WORKER_H
+#define DB_WORKER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "database.cpp" // Include the Database class
+
+// Runs database jobs on a dedicated thread with its own connection, so the UI
+// never waits on SQLite's journal sync. Jobs are fed through a bounded queue
+// (submit() blocks only when it is full); completions are collected and run on
+// the caller's thread by poll(). Jobs run in submission order.
+//
+// When the connection uses group commit, a job's completion is held back until
+// the batch containing it has been committed, so "ok" always means durable.
+// Idle batches are committed when their window runs out, on drain() and on exit.
+class DatabaseWorker {
+public:
+    using Job = function<bool(Database&)>;
+    using Completion = function<void(bool ok)>;
+
+    explicit DatabaseWorker(const string& dbName, const DatabaseOptions& options = {}, size_t queueCapacity = 1024)
+        : db(dbName, options), capacity(queueCapacity) {
+        thread = std::thread([this] { loop(); });
+    }
+
+    DatabaseWorker(const DatabaseWorker&) = delete;
+    DatabaseWorker& operator=(const DatabaseWorker&) = delete;
+
+    // Finishes every queued job and commits the last batch before the thread
+    // exits. Completions that were never polled are dropped.
+    ~DatabaseWorker() {
+        {
+            lock_guard<mutex> lock(queueMutex);
+            stopping = true;
+        }
+        jobReady.notify_all();
+        thread.join();
+    }
+
+    void submit(Job job, Completion done) {
+        unique_lock<mutex> lock(queueMutex);
+        spaceFree.wait(lock, [this] { return jobs.size() < capacity; });
+        jobs.push_back({std::move(job), std::move(done)});
+        inFlight++;
+        lock.unlock();
+        jobReady.notify_one();
+    }
+
+    // Runs job after every job submitted before it and waits for its result.
+    // The job sees those writes even while their batch is still open, so a
+    // read through here matches what the caller already wrote.
+    bool call(const Job& job) {
+        mutex resultMutex;
+        condition_variable resultReady;
+        bool ran = false;
+        bool result = false;
+        submit([&](Database& target) {
+            bool ok = job(target);
+            {
+                lock_guard<mutex> lock(resultMutex);
+                result = ok;
+                ran = true;
+            }
+            resultReady.notify_one();
+            return true; // Reads have nothing to commit or revert
+        }, nullptr);
+        unique_lock<mutex> lock(resultMutex);
+        resultReady.wait(lock, [&] { return ran; });
+        return result;
+    }
+
+    // Runs the completions of finished jobs on the calling thread.
+    // Returns how many were run.
+    size_t poll() {
+        vector<Finished> ready;
+        {
+            lock_guard<mutex> lock(finishedMutex);
+            ready.swap(finished);
+        }
+        for (Finished& result : ready) {
+            if (result.done) {
+                result.done(result.ok);
+            }
+        }
+        inFlight -= ready.size();
+        return ready.size();
+    }
+
+    // Blocks until every submitted job has run and been committed, then polls
+    // their completions.
+    void drain() {
+        unique_lock<mutex> lock(queueMutex);
+        flushRequested = true;
+        jobReady.notify_one();
+        idle.wait(lock, [this] { return jobs.empty() && !busy && !batchOpen; });
+        lock.unlock();
+        poll();
+    }
+
+    // Called on the worker thread whenever completions become ready, so an
+    // event loop can wake up and poll() them. Set before submitting jobs.
+    void setNotify(function<void()> callback) {
+        notify = std::move(callback);
+    }
+
+    // Scopes the worker's connection to a user, as Database::setUser(), for
+    // every job submitted after this call.
+    void setUser(long long id) {
+        submit([id](Database& target) {
+            target.setUser(id);
+            return true;
+        }, nullptr);
+    }
+
+    // Jobs submitted whose completion has not been polled yet.
+    size_t pending() const {
+        return inFlight;
+    }
+
+private:
+    struct Task {
+        Job job;
+        Completion done;
+    };
+
+    struct Finished {
+        Completion done;
+        bool ok;
+    };
+
+    Database db; // Only touched from the worker thread once it has started
+    size_t capacity;
+    std::thread thread;
+
+    mutex queueMutex;
+    condition_variable jobReady;
+    condition_variable spaceFree;
+    condition_variable idle;
+    deque<Task> jobs;
+    bool busy = false;
+    bool stopping = false;
+    bool flushRequested = false;
+    bool batchOpen = false; // Mirrors db.inBatch() for other threads
+
+    vector<Finished> uncommitted; // Completions waiting for their batch to commit (worker thread only)
+
+    mutex finishedMutex;
+    vector<Finished> finished;
+    atomic<size_t> inFlight{0};
+    function<void()> notify;
+
+    void loop() {
+        while (true) {
+            Task task;
+            bool haveTask = false;
+            {
+                unique_lock<mutex> lock(queueMutex);
+                auto ready = [this] { return stopping || flushRequested || !jobs.empty(); };
+                if (db.inBatch()) {
+                    jobReady.wait_for(lock, db.batchTimeLeft(), ready); // Wake up when the batch is due
+                } else {
+                    jobReady.wait(lock, ready);
+                }
+                if (!jobs.empty()) {
+                    task = std::move(jobs.front());
+                    jobs.pop_front();
+                    haveTask = true;
+                    busy = true;
+                } else if (stopping && !db.inBatch()) {
+                    return; // Stopping and nothing left to run or commit
+                }
+            }
+
+            if (haveTask) {
+                spaceFree.notify_one();
+                bool ok = task.job(db);
+                uncommitted.push_back({std::move(task.done), ok});
+                if (!db.inBatch()) {
+                    publish(db.lastFlushSucceeded()); // Autocommit, or this write closed the batch
+                }
+            } else if (db.inBatch() && (stopping || flushRequested || db.batchTimeLeft().count() <= 0)) {
+                publish(db.flush());
+            }
+
+            {
+                lock_guard<mutex> lock(queueMutex);
+                busy = false;
+                batchOpen = db.inBatch();
+                if (jobs.empty() && !batchOpen) {
+                    flushRequested = false;
+                }
+            }
+            idle.notify_all();
+        }
+    }
+
+    // Hands the held completions to poll(), failing them all if their commit failed.
+    void publish(bool committed) {
+        if (uncommitted.empty()) {
+            return;
+        }
+        {
+            lock_guard<mutex> lock(finishedMutex);
+            for (Finished& result : uncommitted) {
+                finished.push_back({std::move(result.done), result.ok && committed});
+            }
+            uncommitted.clear();
+        }
+        if (notify) {
+            notify();
+        }
+    }
+};
+
+#endif // DB_WORKER_H
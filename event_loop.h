@@ -0,0 +1,193 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <ncurses.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "render.h" // Include the Screen the loop reads keys from
+
+// Something for the screen in front to react to. Key and Mouse come from the
+// terminal, Resize after the panes were already resized, Timer when a timer
+// from EventLoop::every/after is due, Wakeup when another thread called wake().
+struct Event {
+    enum Type { Key, Mouse, Resize, Timer, Wakeup };
+
+    Type type;
+    int key = ERR;   // Key: the ncurses key code
+    MEVENT mouse{};  // Mouse: position and buttons
+    int timer = -1;  // Timer: the id returned by every/after
+};
+
+// The one place the TUI waits. next() blocks in poll() on stdin and an eventfd
+// until a key arrives, a timer is due or another thread calls wake(), so work
+// finished in the background redraws the screen without waiting for a key.
+// Each screen runs its draw/handle pair through run(); a screen opened from
+// another nests inside it, and background handlers keep firing at every level.
+class EventLoop {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit EventLoop(Screen& display) : screen(display), wakeFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {}
+
+    ~EventLoop() {
+        if (wakeFd >= 0) {
+            close(wakeFd);
+        }
+    }
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // Makes the UI thread's next() return a Wakeup event. Safe from any thread.
+    void wake() {
+        uint64_t one = 1;
+        if (write(wakeFd, &one, sizeof(one)) < 0) {
+            // The counter only saturates if nobody reads it; a wakeup is pending anyway
+        }
+    }
+
+    // Runs handler on the UI thread for every wakeup, before the screen sees it.
+    void onWakeup(std::function<void()> handler) {
+        wakeupHandlers.push_back(std::move(handler));
+    }
+
+    // Runs callback on the UI thread every intervalMs. Returns the timer id.
+    int every(int intervalMs, std::function<void()> callback) {
+        return addTimer(intervalMs, true, std::move(callback));
+    }
+
+    // Delivers one Timer event carrying the returned id after delayMs.
+    int after(int delayMs) {
+        return addTimer(delayMs, false, nullptr);
+    }
+
+    void cancel(int id) {
+        for (size_t i = 0; i < timers.size(); ++i) {
+            if (timers[i].id == id) {
+                timers.erase(timers.begin() + i);
+                return;
+            }
+        }
+    }
+
+    // Flushes pending drawing to the terminal and waits for the next event.
+    Event next() {
+        while (true) {
+            int ch = screen.pollKey(); // Keys ncurses already buffered come first
+            if (ch == KEY_RESIZE) {
+                return {Event::Resize};
+            } else if (ch == KEY_MOUSE) {
+                Event event{Event::Mouse};
+                if (getmouse(&event.mouse) == OK) {
+                    return event;
+                }
+                continue;
+            } else if (ch != ERR) {
+                Event event{Event::Key};
+                event.key = ch;
+                return event;
+            }
+
+            Clock::time_point now = Clock::now();
+            for (size_t i = 0; i < timers.size(); ++i) {
+                if (timers[i].due <= now) {
+                    Timer timer = timers[i];
+                    if (timer.repeat) {
+                        timers[i].due = now + timer.interval;
+                    } else {
+                        timers.erase(timers.begin() + i);
+                    }
+                    if (timer.callback) {
+                        timer.callback();
+                    }
+                    Event event{Event::Timer};
+                    event.timer = timer.id;
+                    return event;
+                }
+            }
+
+            screen.update();
+            pollfd fds[2] = {{STDIN_FILENO, POLLIN, 0}, {wakeFd, POLLIN, 0}};
+            if (poll(fds, 2, timeoutMs(now)) < 0 && errno != EINTR) {
+                continue; // EINTR is usually SIGWINCH; the next key read reports it
+            }
+            if (fds[1].revents & POLLIN) {
+                uint64_t count;
+                while (read(wakeFd, &count, sizeof(count)) > 0) {
+                }
+                for (const std::function<void()>& handler : wakeupHandlers) {
+                    handler();
+                }
+                return {Event::Wakeup};
+            }
+        }
+    }
+
+    // Calls draw, then hands the next event to handle, until handle returns
+    // false. Drawing only touches rows that changed, so redrawing after every
+    // event is cheap.
+    void run(const std::function<void()>& draw, const std::function<bool(const Event&)>& handle) {
+        while (true) {
+            draw();
+            if (!handle(next())) {
+                return;
+            }
+        }
+    }
+
+    // Waits for any key, keeping background work going meanwhile.
+    int waitForKey() {
+        int key = ERR;
+        run([] {}, [&](const Event& event) {
+            if (event.type == Event::Key || event.type == Event::Mouse) {
+                key = event.type == Event::Key ? event.key : KEY_MOUSE;
+                return false;
+            }
+            return true;
+        });
+        return key;
+    }
+
+private:
+    struct Timer {
+        int id;
+        Clock::time_point due;
+        Clock::duration interval;
+        bool repeat;
+        std::function<void()> callback;
+    };
+
+    Screen& screen;
+    int wakeFd;
+    int nextTimerId = 0;
+    std::vector<Timer> timers;
+    std::vector<std::function<void()>> wakeupHandlers;
+
+    int addTimer(int ms, bool repeat, std::function<void()> callback) {
+        std::chrono::milliseconds interval(ms);
+        timers.push_back({nextTimerId, Clock::now() + interval, interval, repeat, std::move(callback)});
+        return nextTimerId++;
+    }
+
+    // Milliseconds until the earliest timer is due, or -1 to wait indefinitely.
+    int timeoutMs(Clock::time_point now) const {
+        int timeout = -1;
+        for (const Timer& timer : timers) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(timer.due - now).count() + 1;
+            if (timeout < 0 || left < timeout) {
+                timeout = static_cast<int>(left);
+            }
+        }
+        return timeout;
+    }
+};
+
+#endif // EVENT_LOOP_H
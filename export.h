@@ -0,0 +1,272 @@
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "database.cpp" // Include the Database class
+#include "question.h"   // Include the Question struct definition
+
+// Append-only output buffer that hands data to write(2) in large blocks.
+// Errors are sticky: once a write fails, later output is dropped and ok()
+// stays false.
+class BufferedWriter {
+public:
+    static constexpr size_t CAPACITY = 1 << 20;
+
+    explicit BufferedWriter(int fileDescriptor) : fd(fileDescriptor), buffer(new char[CAPACITY]) {}
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    ~BufferedWriter() {
+        flush();
+        delete[] buffer;
+    }
+
+    void put(char c) {
+        if (used == CAPACITY) {
+            flush();
+        }
+        buffer[used++] = c;
+    }
+
+    void put(string_view data) {
+        if (data.size() > CAPACITY - used) {
+            flush();
+            if (data.size() > CAPACITY) {
+                writeAll(data.data(), data.size());
+                return;
+            }
+        }
+        memcpy(buffer + used, data.data(), data.size());
+        used += data.size();
+    }
+
+    void putNumber(long long value) {
+        char digits[24];
+        int length = snprintf(digits, sizeof(digits), "%lld", value);
+        put(string_view(digits, length));
+    }
+
+    bool flush() {
+        writeAll(buffer, used);
+        used = 0;
+        return failed == 0;
+    }
+
+    bool ok() const {
+        return failed == 0;
+    }
+
+    int error() const {
+        return failed;
+    }
+
+private:
+    int fd;
+    char* buffer;
+    size_t used = 0;
+    int failed = 0; // errno of the first failed write
+
+    void writeAll(const char* data, size_t length) {
+        while (length > 0 && failed == 0) {
+            ssize_t n = ::write(fd, data, length);
+            if (n < 0) {
+                if (errno != EINTR) {
+                    failed = errno;
+                }
+                continue;
+            }
+            data += n;
+            length -= static_cast<size_t>(n);
+        }
+    }
+};
+
+// Text is stored as UTF-8, so only quotes, backslashes and control
+// characters need escaping. Runs of plain bytes are copied in one go.
+inline void writeJsonString(BufferedWriter& out, string_view text) {
+    out.put('"');
+    size_t start = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        out.put(text.substr(start, i - start));
+        start = i + 1;
+        switch (c) {
+            case '"': out.put("\\\""); break;
+            case '\\': out.put("\\\\"); break;
+            case '\n': out.put("\\n"); break;
+            case '\r': out.put("\\r"); break;
+            case '\t': out.put("\\t"); break;
+            default: {
+                char escape[8];
+                snprintf(escape, sizeof(escape), "\\u%04x", c);
+                out.put(escape);
+            }
+        }
+    }
+    out.put(text.substr(start));
+    out.put('"');
+}
+
+enum class ExportFormat { Csv, Json, Jsonl };
+
+// Writes rows in a format `tui_program import` reads back: statuses are written
+// by name and CSV starts with a number,text,status header.
+class QuestionExporter {
+public:
+    QuestionExporter(BufferedWriter& output, ExportFormat exportFormat) : out(output), format(exportFormat) {}
+
+    void begin() {
+        if (format == ExportFormat::Csv) {
+            out.put("number,text,status\n");
+        } else if (format == ExportFormat::Json) {
+            out.put('[');
+        }
+    }
+
+    void write(const QuestionView& question) {
+        if (format == ExportFormat::Csv) {
+            out.putNumber(question.number);
+            out.put(',');
+            putCsvField(question.text);
+            out.put(',');
+            out.put(statusName(question.status));
+            out.put('\n');
+            return;
+        }
+        if (format == ExportFormat::Json) {
+            out.put(rows == 0 ? "\n" : ",\n");
+        }
+        out.put("{\"number\":");
+        out.putNumber(question.number);
+        out.put(",\"text\":");
+        writeJsonString(out, question.text);
+        out.put(",\"status\":\"");
+        out.put(statusName(question.status));
+        out.put(format == ExportFormat::Json ? "\"}" : "\"}\n");
+        rows++;
+    }
+
+    void end() {
+        if (format == ExportFormat::Json) {
+            out.put(rows == 0 ? "]\n" : "\n]\n");
+        }
+    }
+
+private:
+    BufferedWriter& out;
+    ExportFormat format;
+    size_t rows = 0;
+
+    // Quotes the field only when it contains a separator, quote or line break.
+    void putCsvField(string_view text) {
+        if (text.find_first_of(",\"\r\n") == string_view::npos) {
+            out.put(text);
+            return;
+        }
+        out.put('"');
+        size_t start = 0;
+        size_t quote;
+        while ((quote = text.find('"', start)) != string_view::npos) {
+            out.put(text.substr(start, quote + 1 - start));
+            out.put('"');
+            start = quote + 1;
+        }
+        out.put(text.substr(start));
+        out.put('"');
+    }
+};
+
+// Entry point for `tui_program export [file|-] [--format=csv|json|jsonl]
+// [--status=NAME]`. Writes the signed-in user's questions to stdout when no
+// file (or "-") is given. Returns the process exit code.
+inline int runExport(const string& dbName, long long user, int argc, char** argv) {
+    string path;
+    optional<ExportFormat> format;
+    optional<Status> filter;
+    for (int i = 0; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--format=csv") {
+            format = ExportFormat::Csv;
+        } else if (arg == "--format=json") {
+            format = ExportFormat::Json;
+        } else if (arg == "--format=jsonl") {
+            format = ExportFormat::Jsonl;
+        } else if (arg.rfind("--status=", 0) == 0) {
+            Status status;
+            if (!parseStatusArgument(arg.substr(9), status)) {
+                cerr << "Unknown status: " << arg.substr(9) << endl;
+                return 2;
+            }
+            filter = status;
+        } else if (path.empty() && (arg == "-" || arg.rfind("--", 0) != 0)) {
+            path = arg;
+        } else {
+            cerr << "Usage: tui_program export [file|-] [--format=csv|json|jsonl] [--status=NAME]" << endl;
+            return 2;
+        }
+    }
+    bool toStdout = path.empty() || path == "-";
+    if (!format) {
+        size_t dot = path.rfind('.');
+        string extension = toStdout || dot == string::npos ? "" : path.substr(dot);
+        format = extension == ".json" ? ExportFormat::Json
+               : extension == ".jsonl" || extension == ".ndjson" ? ExportFormat::Jsonl
+               : ExportFormat::Csv;
+    }
+
+    int fd = STDOUT_FILENO;
+    if (!toStdout) {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            cerr << "Cannot write " << path << ": " << strerror(errno) << endl;
+            return 1;
+        }
+    }
+
+    Database db(dbName);
+    db.setUser(user);
+    auto start = chrono::steady_clock::now();
+    size_t rows = 0;
+    bool ok;
+    int writeError;
+    {
+        BufferedWriter out(fd);
+        QuestionExporter exporter(out, *format);
+        exporter.begin();
+        ok = db.forEachQuestion([&](const QuestionView& question) {
+            exporter.write(question);
+            rows++;
+            return out.ok(); // Stop early if the output has gone away
+        }, filter);
+        exporter.end();
+        out.flush();
+        writeError = out.error();
+    }
+    if (!toStdout && ::close(fd) != 0 && writeError == 0) {
+        writeError = errno;
+    }
+    if (writeError != 0) {
+        cerr << "Export failed: " << strerror(writeError) << endl;
+        return 1;
+    }
+    if (!toStdout) {
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        printf("Exported %zu question(s) to %s in %.2f s\n", rows, path.c_str(), seconds);
+    }
+    return ok ? 0 : 1;
+}
+
+#endif // EXPORT_H
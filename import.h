@@ -0,0 +1,520 @@
+#ifndef IMPORT_H
+#define IMPORT_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "database.cpp"     // Include the Database class
+#include "question.h"       // Include the Question struct definition
+#include "question_index.h" // Include parseQuestionNumber
+
+// Read-only memory map of a whole file. Pages are faulted in as the parser walks
+// forward and can be dropped again by the kernel, so resident memory does not
+// grow with the size of the file.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        if (base) {
+            munmap(base, length);
+        }
+    }
+
+    bool open(const string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+            ::close(fd);
+            return false;
+        }
+        length = static_cast<size_t>(info.st_size);
+        if (length > 0) {
+            void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                ::close(fd);
+                return false;
+            }
+            base = static_cast<char*>(mapped);
+            madvise(base, length, MADV_SEQUENTIAL);
+        }
+        ::close(fd);
+        return true;
+    }
+
+    const char* begin() const { return base; }
+    const char* end() const { return base + length; }
+
+private:
+    char* base = nullptr;
+    size_t length = 0;
+};
+
+// Raw fields of one input record, before validation.
+struct ImportRecord {
+    size_t line = 0; // Line the record starts on, for error messages
+    string number;
+    string text;
+    string status;
+};
+
+// Parser stage for CSV (RFC 4180 quoting, embedded newlines allowed).
+// Columns are number,text,status unless a header row names them.
+class CsvParser {
+public:
+    CsvParser(const char* begin, const char* end) : cursor(begin), limit(end) {}
+
+    bool next(ImportRecord& record) {
+        while (cursor < limit) {
+            record.line = line;
+            if (!readFields()) {
+                continue; // Blank line
+            }
+            if (!headerChecked) {
+                headerChecked = true;
+                if (isHeader()) {
+                    continue;
+                }
+            }
+            record.number = field(numberColumn);
+            record.text = field(textColumn);
+            record.status = field(statusColumn);
+            return true;
+        }
+        return false;
+    }
+
+private:
+    const char* cursor;
+    const char* limit;
+    size_t line = 1;
+    bool headerChecked = false;
+    size_t numberColumn = 0;
+    size_t textColumn = 1;
+    size_t statusColumn = 2;
+    vector<string> fields;
+
+    string field(size_t column) const {
+        return column < fields.size() ? fields[column] : string();
+    }
+
+    // Reads one record into fields. Returns false for an empty line.
+    bool readFields() {
+        fields.clear();
+        string current;
+        bool quoted = false;
+        bool any = false;
+        while (cursor < limit) {
+            char c = *cursor++;
+            if (quoted) {
+                if (c == '"') {
+                    if (cursor < limit && *cursor == '"') {
+                        current += '"';
+                        cursor++;
+                    } else {
+                        quoted = false;
+                    }
+                } else {
+                    if (c == '\n') {
+                        line++;
+                    }
+                    current += c;
+                }
+            } else if (c == '"') {
+                quoted = true;
+                any = true;
+            } else if (c == ',') {
+                fields.push_back(std::move(current));
+                current.clear();
+                any = true;
+            } else if (c == '\n') {
+                line++;
+                break;
+            } else if (c != '\r') {
+                current += c;
+                any = true;
+            }
+        }
+        if (!any) {
+            return false;
+        }
+        fields.push_back(std::move(current));
+        return true;
+    }
+
+    // A first row whose number column is not numeric is taken as a header.
+    bool isHeader() {
+        int ignored;
+        if (fields.empty() || parseQuestionNumber(fields[0], ignored)) {
+            return false;
+        }
+        for (size_t i = 0; i < fields.size(); ++i) {
+            string name = fields[i];
+            for (char& c : name) {
+                c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+            }
+            if (name == "number" || name == "id") {
+                numberColumn = i;
+            } else if (name == "text" || name == "title") {
+                textColumn = i;
+            } else if (name == "status") {
+                statusColumn = i;
+            }
+        }
+        return true;
+    }
+};
+
+// Parser stage for JSON Lines: one flat object per line with "number", "text"
+// (or "title") and "status" keys. Other keys are ignored.
+class JsonlParser {
+public:
+    JsonlParser(const char* begin, const char* end) : cursor(begin), limit(end) {}
+
+    // Returns false at end of input. Malformed lines come back with ok == false.
+    bool next(ImportRecord& record, bool& ok) {
+        while (cursor < limit) {
+            const char* lineEnd = static_cast<const char*>(memchr(cursor, '\n', limit - cursor));
+            if (!lineEnd) {
+                lineEnd = limit;
+            }
+            const char* p = cursor;
+            cursor = lineEnd < limit ? lineEnd + 1 : limit;
+            record.line = line++;
+            skipSpace(p, lineEnd);
+            if (p == lineEnd) {
+                continue; // Blank line
+            }
+            record.number.clear();
+            record.text.clear();
+            record.status.clear();
+            ok = parseObject(p, lineEnd, record);
+            return true;
+        }
+        return false;
+    }
+
+private:
+    const char* cursor;
+    const char* limit;
+    size_t line = 1;
+
+    static void skipSpace(const char*& p, const char* end) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+            p++;
+        }
+    }
+
+    static void appendUtf8(string& out, unsigned long code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    static bool parseHex4(const char*& p, const char* end, unsigned long& code) {
+        if (end - p < 4) {
+            return false;
+        }
+        code = 0;
+        for (int i = 0; i < 4; ++i, ++p) {
+            char c = *p;
+            code <<= 4;
+            if (c >= '0' && c <= '9') code |= c - '0';
+            else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+            else return false;
+        }
+        return true;
+    }
+
+    static bool parseString(const char*& p, const char* end, string& out) {
+        if (p >= end || *p != '"') {
+            return false;
+        }
+        p++;
+        while (p < end) {
+            char c = *p++;
+            if (c == '"') {
+                return true;
+            }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (p >= end) {
+                return false;
+            }
+            char escape = *p++;
+            switch (escape) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    unsigned long code;
+                    if (!parseHex4(p, end, code)) {
+                        return false;
+                    }
+                    if (code >= 0xD800 && code <= 0xDBFF && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                        p += 2;
+                        unsigned long low;
+                        if (!parseHex4(p, end, low)) {
+                            return false;
+                        }
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, code);
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        return false;
+    }
+
+    // Strings are unescaped; numbers and literals are kept as written.
+    static bool parseValue(const char*& p, const char* end, string& out) {
+        if (p < end && *p == '"') {
+            return parseString(p, end, out);
+        }
+        const char* start = p;
+        while (p < end && *p != ',' && *p != '}' && *p != ' ' && *p != '\t' && *p != '\r') {
+            p++;
+        }
+        out.assign(start, p);
+        return p > start && *start != '{' && *start != '[';
+    }
+
+    static bool parseObject(const char*& p, const char* end, ImportRecord& record) {
+        if (*p != '{') {
+            return false;
+        }
+        p++;
+        skipSpace(p, end);
+        if (p < end && *p == '}') {
+            return true;
+        }
+        while (p < end) {
+            string key;
+            string value;
+            skipSpace(p, end);
+            if (!parseString(p, end, key)) {
+                return false;
+            }
+            skipSpace(p, end);
+            if (p >= end || *p != ':') {
+                return false;
+            }
+            p++;
+            skipSpace(p, end);
+            if (!parseValue(p, end, value)) {
+                return false;
+            }
+            if (key == "number" || key == "id") {
+                record.number = std::move(value);
+            } else if (key == "text" || key == "title") {
+                record.text = std::move(value);
+            } else if (key == "status") {
+                record.status = std::move(value);
+            }
+            skipSpace(p, end);
+            if (p < end && *p == ',') {
+                p++;
+                continue;
+            }
+            return p < end && *p == '}';
+        }
+        return false;
+    }
+};
+
+struct ImportOptions {
+    bool jsonl = false;       // Input format: JSON Lines instead of CSV
+    bool overwrite = false;   // Upsert existing numbers instead of skipping them
+    size_t batchSize = 50000; // Rows per transaction
+};
+
+struct ImportStats {
+    size_t written = 0;  // Inserted, or overwritten with --on-conflict=upsert
+    size_t skipped = 0;  // Already present with --on-conflict=skip, or repeated in the file
+    size_t rejected = 0; // Failed validation or could not be written
+};
+
+// Streams a CSV or JSONL file through parse and validate stages into the
+// questions table. Valid rows are staged through one reused statement and
+// merged with one transaction per batch.
+class Importer {
+public:
+    Importer(Database& database, const ImportOptions& importOptions) : db(database), options(importOptions) {}
+
+    bool run(const string& path, ImportStats& stats) {
+        MappedFile file;
+        if (!file.open(path)) {
+            cerr << "Cannot read " << path << ": " << strerror(errno) << endl;
+            return false;
+        }
+        ImportRecord record;
+        if (options.jsonl) {
+            JsonlParser parser(file.begin(), file.end());
+            bool ok;
+            while (parser.next(record, ok)) {
+                if (!ok) {
+                    reject(record, "malformed JSON object", stats);
+                    continue;
+                }
+                store(record, stats);
+            }
+        } else {
+            CsvParser parser(file.begin(), file.end());
+            while (parser.next(record)) {
+                store(record, stats);
+            }
+        }
+        return merge(stats) && failedBatches == 0;
+    }
+
+private:
+    static constexpr size_t MAX_REPORTED_ERRORS = 20;
+
+    Database& db;
+    ImportOptions options;
+    size_t reportedErrors = 0;
+    size_t staged = 0;        // Accepted rows waiting in the current batch
+    size_t failedBatches = 0;
+
+    // Writes the current batch. Rows that were accepted but not written were
+    // already present (or repeated within the batch) and are counted as skipped.
+    bool merge(ImportStats& stats) {
+        size_t written = 0;
+        bool ok = db.mergeImport(options.overwrite, written);
+        if (ok) {
+            stats.written += written;
+            stats.skipped += staged - min(staged, written);
+        } else {
+            stats.rejected += staged;
+            failedBatches++;
+            cerr << "A batch of " << staged << " question(s) could not be written" << endl;
+        }
+        staged = 0;
+        return ok;
+    }
+
+    void reject(const ImportRecord& record, const char* reason, ImportStats& stats) {
+        stats.rejected++;
+        if (reportedErrors++ < MAX_REPORTED_ERRORS) {
+            cerr << "line " << record.line << ": " << reason << endl;
+        }
+    }
+
+    // Validation stage. Status is parsed with parseStatusArgument; a missing
+    // status imports the problem as Not Understood.
+    static bool validStatus(const string& text, Status& status) {
+        if (text.empty()) {
+            status = Status::NotUnderstood;
+            return true;
+        }
+        return parseStatusArgument(text, status);
+    }
+
+    void store(const ImportRecord& record, ImportStats& stats) {
+        int number;
+        Status status;
+        if (!parseQuestionNumber(record.number, number)) {
+            reject(record, "question number must be a non-negative integer", stats);
+            return;
+        }
+        if (record.text.empty()) {
+            reject(record, "question text is required", stats);
+            return;
+        }
+        if (!validStatus(record.status, status)) {
+            reject(record, "unknown status", stats);
+            return;
+        }
+        if (!db.stageImport(number, record.text, status, options.overwrite)) {
+            reject(record, "database write failed", stats);
+            return;
+        }
+        if (++staged >= options.batchSize) {
+            merge(stats);
+        }
+    }
+};
+
+// Entry point for `tui_program import <file> [--format=csv|jsonl]
+// [--on-conflict=skip|upsert] [--batch=N]`. Rows go to the signed-in user.
+// Returns the process exit code.
+inline int runImport(const string& dbName, long long user, int argc, char** argv) {
+    string path;
+    ImportOptions options;
+    bool formatGiven = false;
+    for (int i = 0; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--format=csv" || arg == "--format=jsonl") {
+            options.jsonl = arg == "--format=jsonl";
+            formatGiven = true;
+        } else if (arg == "--on-conflict=skip" || arg == "--on-conflict=upsert") {
+            options.overwrite = arg == "--on-conflict=upsert";
+        } else if (arg.rfind("--batch=", 0) == 0) {
+            options.batchSize = max<size_t>(1, strtoul(arg.c_str() + 8, nullptr, 10));
+        } else if (path.empty() && arg.rfind("--", 0) != 0) {
+            path = arg;
+        } else {
+            cerr << "Unknown import option: " << arg << endl;
+            return 2;
+        }
+    }
+    if (path.empty()) {
+        cerr << "Usage: tui_program import <file> [--format=csv|jsonl] [--on-conflict=skip|upsert] [--batch=N]" << endl;
+        return 2;
+    }
+    if (!formatGiven) {
+        size_t dot = path.rfind('.');
+        string extension = dot == string::npos ? "" : path.substr(dot);
+        options.jsonl = extension == ".jsonl" || extension == ".ndjson" || extension == ".json";
+    }
+
+    Database db(dbName, withEnvironmentOverrides(DatabaseOptions()));
+    db.setUser(user);
+
+    auto start = chrono::steady_clock::now();
+    ImportStats stats;
+    Importer importer(db, options);
+    bool ok = importer.run(path, stats);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    printf("Imported %zu question(s), skipped %zu existing or repeated, rejected %zu in %.2f s\n",
+           stats.written, stats.skipped, stats.rejected, seconds);
+    return ok ? 0 : 1;
+}
+
+#endif // IMPORT_H
@@ -0,0 +1,141 @@
+#ifndef INCREMENTAL_SEARCH_H
+#define INCREMENTAL_SEARCH_H
+
+#include <cctype>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "question.h"       // Include the Question struct definition
+#include "question_cache.h" // Include the write-through question cache
+
+// Result reuse for search-as-you-type on top of QuestionCache::searchText.
+// When a new query only extends the previous one, the previous result set is
+// filtered in memory instead of asking FTS5 again; this is exact as long as the
+// previous set was not cut off by the limit. Recent result sets are also kept
+// so that backspacing to an earlier query is answered without a search.
+class IncrementalSearch {
+public:
+    IncrementalSearch(QuestionCache& cache, int resultLimit) : questions(cache), limit(resultLimit) {}
+
+    // Answers the query from earlier results if possible. Returns false when a
+    // database search is needed.
+    bool reuse(const string& query) {
+        for (const Snapshot& snapshot : history) {
+            if (snapshot.query == query) {
+                remember(query, vector<Question>(snapshot.results), snapshot.complete);
+                return true;
+            }
+        }
+        if (!canNarrow(query)) {
+            return false;
+        }
+        vector<string> words = splitWords(query);
+        vector<Question> narrowed;
+        for (const Question& question : current.results) {
+            if (matchesAll(question.text, words)) {
+                narrowed.push_back(question); // Keeps the previous rank order
+            }
+        }
+        remember(query, std::move(narrowed), true);
+        return true;
+    }
+
+    // Runs the query against the full-text index. Returns false, leaving the
+    // current results untouched, if cancelled() asked to abandon it.
+    bool search(const string& query, const function<bool()>& cancelled) {
+        vector<Question> found;
+        if (!questions.searchText(query, limit, found, cancelled)) {
+            return false;
+        }
+        bool complete = static_cast<int>(found.size()) < limit;
+        remember(query, std::move(found), complete);
+        return true;
+    }
+
+    const vector<Question>& results() const {
+        return current.results;
+    }
+
+    // The query the current results belong to.
+    const string& query() const {
+        return current.query;
+    }
+
+private:
+    struct Snapshot {
+        string query;
+        vector<Question> results;
+        bool complete = true; // False if the limit may have cut off matches
+    };
+
+    static constexpr size_t HISTORY_SIZE = 32;
+
+    QuestionCache& questions;
+    int limit;
+    Snapshot current;
+    deque<Snapshot> history; // Most recent first
+
+    void remember(const string& query, vector<Question> results, bool complete) {
+        current = {query, std::move(results), complete};
+        history.push_front(current);
+        if (history.size() > HISTORY_SIZE) {
+            history.pop_back();
+        }
+    }
+
+    // Narrowing is exact only when the new query adds constraints to a complete
+    // result set. Non-ASCII input is left to FTS5, whose case folding and
+    // diacritic removal are not reproduced here.
+    bool canNarrow(const string& query) const {
+        if (!current.complete || current.query.empty() || splitWords(current.query).empty()) {
+            return false;
+        }
+        if (query.size() <= current.query.size() || query.compare(0, current.query.size(), current.query) != 0) {
+            return false;
+        }
+        for (unsigned char c : query) {
+            if (c >= 0x80) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Lower-cased alphanumeric words, split the same way as Database::toMatchExpression.
+    static vector<string> splitWords(const string& text) {
+        vector<string> words;
+        string word;
+        for (size_t i = 0; i <= text.size(); ++i) {
+            unsigned char c = i < text.size() ? text[i] : ' ';
+            if (isalnum(c) || c >= 0x80) {
+                word += static_cast<char>(tolower(c));
+            } else if (!word.empty()) {
+                words.push_back(word);
+                word.clear();
+            }
+        }
+        return words;
+    }
+
+    // True if every query word is a prefix of some word in the text.
+    static bool matchesAll(const string& text, const vector<string>& queryWords) {
+        vector<string> textWords = splitWords(text);
+        for (const string& queryWord : queryWords) {
+            bool found = false;
+            for (const string& textWord : textWords) {
+                if (textWord.compare(0, queryWord.size(), queryWord) == 0) {
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+#endif // INCREMENTAL_SEARCH_H
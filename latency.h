@@ -0,0 +1,190 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Log-linear latency histogram in the style of HdrHistogram: values below 16 ns
+// get a bucket each, and every power of two above that is split into 16
+// sub-buckets, so any percentile is reported within about 3%. Recording is a
+// couple of relaxed atomic increments, safe from the UI and worker threads.
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKETS = 16;
+    static constexpr int BUCKETS = 61 * SUB_BUCKETS;
+
+    explicit LatencyHistogram(std::string operation) : name(std::move(operation)) {}
+
+    void record(uint64_t nanos) {
+        buckets[bucketOf(nanos)].fetch_add(1, std::memory_order_relaxed);
+        calls.fetch_add(1, std::memory_order_relaxed);
+        uint64_t seen = maximum.load(std::memory_order_relaxed);
+        while (nanos > seen && !maximum.compare_exchange_weak(seen, nanos, std::memory_order_relaxed)) {
+        }
+    }
+
+    const std::string& operation() const {
+        return name;
+    }
+
+    uint64_t count() const {
+        return calls.load(std::memory_order_relaxed);
+    }
+
+    uint64_t max() const {
+        return maximum.load(std::memory_order_relaxed);
+    }
+
+    // Latency at or below which the given fraction (0..1) of calls completed,
+    // as the midpoint of the bucket it falls in.
+    uint64_t percentile(double fraction) const {
+        uint64_t total = count();
+        if (total == 0) {
+            return 0;
+        }
+        uint64_t target = static_cast<uint64_t>(fraction * total + 0.5);
+        target = target == 0 ? 1 : target;
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; ++i) {
+            seen += buckets[i].load(std::memory_order_relaxed);
+            if (seen >= target) {
+                uint64_t value = midpointOf(i);
+                return value < max() ? value : max();
+            }
+        }
+        return max();
+    }
+
+private:
+    std::string name;
+    std::atomic<uint64_t> buckets[BUCKETS] = {};
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> maximum{0};
+
+    static int bucketOf(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<int>(value);
+        }
+        int exponent = 63 - __builtin_clzll(value);
+        int sub = static_cast<int>((value >> (exponent - 4)) & (SUB_BUCKETS - 1));
+        return (exponent - 3) * SUB_BUCKETS + sub;
+    }
+
+    static uint64_t midpointOf(int bucket) {
+        if (bucket < SUB_BUCKETS) {
+            return static_cast<uint64_t>(bucket);
+        }
+        int exponent = bucket / SUB_BUCKETS + 3;
+        uint64_t low = static_cast<uint64_t>(SUB_BUCKETS + bucket % SUB_BUCKETS) << (exponent - 4);
+        uint64_t width = 1ULL << (exponent - 4);
+        return low + width / 2;
+    }
+};
+
+// Every histogram in the process, in registration order. Histograms live until
+// exit, so call sites can keep a reference in a function-local static.
+class LatencyRegistry {
+public:
+    LatencyHistogram& histogram(const std::string& operation) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (LatencyHistogram& existing : histograms) {
+            if (existing.operation() == operation) {
+                return existing;
+            }
+        }
+        histograms.emplace_back(operation);
+        return histograms.back();
+    }
+
+    std::vector<const LatencyHistogram*> snapshot() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        std::vector<const LatencyHistogram*> all;
+        for (const LatencyHistogram& histogram : histograms) {
+            all.push_back(&histogram);
+        }
+        return all;
+    }
+
+private:
+    std::mutex registryMutex;
+    std::deque<LatencyHistogram> histograms; // deque: references stay valid as it grows
+};
+
+inline LatencyRegistry& latencyRegistry() {
+    static LatencyRegistry registry;
+    return registry;
+}
+
+// Records the lifetime of the enclosing scope into a histogram.
+class ScopedLatency {
+public:
+    explicit ScopedLatency(LatencyHistogram& target) : histogram(target), start(std::chrono::steady_clock::now()) {}
+
+    ~ScopedLatency() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        histogram.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+private:
+    LatencyHistogram& histogram;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define LATENCY_CONCAT_(a, b) a##b
+#define LATENCY_CONCAT(a, b) LATENCY_CONCAT_(a, b)
+
+// Times the rest of the enclosing scope under the given operation name.
+// The histogram is looked up once per call site.
+#define TRACK_LATENCY(operation)                                                                                   \
+    static LatencyHistogram& LATENCY_CONCAT(latencyHistogram_, __LINE__) = latencyRegistry().histogram(operation); \
+    ScopedLatency LATENCY_CONCAT(latencyScope_, __LINE__)(LATENCY_CONCAT(latencyHistogram_, __LINE__))
+
+// Formats one line per operation that has been called: calls, p50, p99, max.
+inline std::vector<std::string> formatLatencyTable() {
+    auto formatNanos = [](uint64_t nanos) {
+        char buffer[32];
+        if (nanos < 10000) {
+            snprintf(buffer, sizeof(buffer), "%llu ns", static_cast<unsigned long long>(nanos));
+        } else if (nanos < 10000000) {
+            snprintf(buffer, sizeof(buffer), "%.1f us", nanos / 1e3);
+        } else {
+            snprintf(buffer, sizeof(buffer), "%.1f ms", nanos / 1e6);
+        }
+        return std::string(buffer);
+    };
+    std::vector<std::string> lines;
+    char line[160];
+    snprintf(line, sizeof(line), "%-36s %10s %10s %10s %10s", "operation", "calls", "p50", "p99", "max");
+    lines.push_back(line);
+    for (const LatencyHistogram* histogram : latencyRegistry().snapshot()) {
+        if (histogram->count() == 0) {
+            continue;
+        }
+        snprintf(line, sizeof(line), "%-36.36s %10llu %10s %10s %10s", histogram->operation().c_str(),
+                 static_cast<unsigned long long>(histogram->count()), formatNanos(histogram->percentile(0.50)).c_str(),
+                 formatNanos(histogram->percentile(0.99)).c_str(), formatNanos(histogram->max()).c_str());
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+// Writes a stats report to the given file, or to stderr when path is empty.
+inline bool writeStatsDump(const std::string& path, const std::vector<std::string>& lines) {
+    FILE* out = path.empty() ? stderr : fopen(path.c_str(), "w");
+    if (!out) {
+        perror(path.c_str());
+        return false;
+    }
+    for (const std::string& line : lines) {
+        fprintf(out, "%s\n", line.c_str());
+    }
+    return out == stderr || fclose(out) == 0;
+}
+
+#endif // LATENCY_H
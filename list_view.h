@@ -0,0 +1,207 @@
+#ifndef LIST_VIEW_H
+#define LIST_VIEW_H
+
+#include <ncurses.h>
+#include <climits>
+#include <deque>
+#include <optional>
+#include <string>
+
+#include "question.h"       // Include the Question struct definition
+#include "question_cache.h" // Include the write-through question cache
+#include "render.h"         // Include the damage-tracked windows
+#include "event_loop.h"     // Include the central event loop
+
+// Scrollable list of questions drawn into the screen's body, with the key help
+// in its status bar. Scrolling by one row rewrites only the rows whose content
+// moved, and ncurses sends just the cells that differ.
+// Only the visible page plus a prefetch margin of one page on either side is
+// held here; rows are fetched with keyset pagination (number > ? / number < ?)
+// so the first frame costs the same no matter how many questions exist. Pages
+// are read through the question cache, on the connection that holds writes
+// the worker has not committed yet. The held rows are re-read whenever the
+// table may have changed under them.
+class QuestionListView {
+public:
+    QuestionListView(Screen& display, EventLoop& eventLoop, QuestionCache& cache, const string& heading,
+                     optional<Status> statusFilter = nullopt)
+        : screen(display), events(eventLoop), questions(cache), title(heading), filter(statusFilter) {}
+
+    // Runs until the user presses ESC or 'q'.
+    void run() {
+        home();
+        events.run([this] { render(); }, [this](const Event& event) { return handle(event); });
+    }
+
+private:
+    Screen& screen;
+    EventLoop& events;
+    QuestionCache& questions;
+    string title;
+    optional<Status> filter;
+    deque<Question> buffer;  // Contiguous run of rows in number order
+    size_t top = 0;          // Buffer index of the first visible row
+    bool atStart = true;     // buffer.front() is the first matching row
+    bool atEnd = true;       // buffer.back() is the last matching row
+
+    // Returns false to close the view.
+    bool handle(const Event& event) {
+        if (event.type == Event::Resize) {
+            scrollDown(0); // Refill for the new page size
+        } else if (event.type == Event::Wakeup || event.type == Event::Timer) {
+            reload(); // A write was confirmed or reverted, or the periodic refresh ran
+        } else if (event.type == Event::Key) {
+            int ch = event.key;
+            if (ch == 27 || ch == 'q') { // ESC key
+                return false;
+            } else if (ch == KEY_DOWN) {
+                scrollDown(1);
+            } else if (ch == KEY_UP) {
+                scrollUp(1);
+            } else if (ch == KEY_NPAGE || ch == ' ') {
+                scrollDown(pageSize());
+            } else if (ch == KEY_PPAGE) {
+                scrollUp(pageSize());
+            } else if (ch == KEY_HOME) {
+                home();
+            } else if (ch == KEY_END) {
+                end();
+            }
+        }
+        return true;
+    }
+
+    int pageSize() const {
+        return max(1, screen.body().height() - 1); // The heading takes one line
+    }
+
+    size_t fetchForward() {
+        long long after = buffer.empty() ? LLONG_MIN : buffer.back().number;
+        vector<Question> page = questions.pageAfter(after, pageSize(), filter);
+        atEnd = static_cast<int>(page.size()) < pageSize();
+        buffer.insert(buffer.end(), page.begin(), page.end());
+        return page.size();
+    }
+
+    size_t fetchBackward() {
+        long long before = buffer.empty() ? LLONG_MAX : buffer.front().number;
+        vector<Question> page = questions.pageBefore(before, pageSize(), filter);
+        atStart = static_cast<int>(page.size()) < pageSize();
+        buffer.insert(buffer.begin(), page.begin(), page.end());
+        top += page.size();
+        return page.size();
+    }
+
+    // Keeps one page of rows prefetched on each side and drops anything further away.
+    void balance() {
+        size_t page = pageSize();
+        while (!atEnd && buffer.size() < top + 2 * page) {
+            if (fetchForward() == 0) {
+                break;
+            }
+        }
+        while (!atStart && top < page) {
+            if (fetchBackward() == 0) {
+                break;
+            }
+        }
+        if (top > 2 * page) {
+            size_t drop = top - page;
+            buffer.erase(buffer.begin(), buffer.begin() + drop);
+            top -= drop;
+            atStart = false;
+        }
+        if (buffer.size() > top + 3 * page) {
+            buffer.erase(buffer.begin() + top + 2 * page, buffer.end());
+            atEnd = false;
+        }
+    }
+
+    size_t lastTop() const {
+        size_t page = pageSize();
+        return buffer.size() > page ? buffer.size() - page : 0;
+    }
+
+    void scrollDown(size_t rows) {
+        size_t target = top + rows;
+        while (!atEnd && target + pageSize() > buffer.size()) {
+            if (fetchForward() == 0) {
+                break;
+            }
+        }
+        top = min(target, lastTop());
+        balance();
+    }
+
+    void scrollUp(size_t rows) {
+        while (!atStart && rows > top) {
+            if (fetchBackward() == 0) {
+                break;
+            }
+        }
+        top = rows > top ? 0 : top - rows;
+        balance();
+    }
+
+    void home() {
+        buffer.clear();
+        top = 0;
+        atStart = true;
+        atEnd = false;
+        fetchForward();
+        balance();
+    }
+
+    void end() {
+        buffer.clear();
+        top = 0;
+        atEnd = true;
+        atStart = false;
+        fetchBackward();
+        top = lastTop();
+        balance();
+    }
+
+    // Re-reads the held rows from the first visible one on, keeping it at the
+    // top if it still exists.
+    void reload() {
+        if (top >= buffer.size()) {
+            home();
+            return;
+        }
+        long long first = buffer[top].number;
+        vector<Question> page = questions.pageAfter(first - 1, pageSize(), filter);
+        if (page.empty()) {
+            end(); // Everything from there on is gone
+            return;
+        }
+        buffer.assign(page.begin(), page.end());
+        top = 0;
+        atStart = false;
+        atEnd = static_cast<int>(page.size()) < pageSize();
+        balance();
+    }
+
+    void render() {
+        TRACK_LATENCY("QuestionListView::render");
+        Pane& body = screen.body();
+        body.setLine(0, title, A_BOLD);
+        int line = 0;
+        if (buffer.empty()) {
+            body.setLine(++line, "No questions to show.");
+        }
+        int page = pageSize();
+        for (; line < page && top + line < buffer.size(); ++line) {
+            const Question& question = buffer[top + line];
+            string row = to_string(question.number) + ": " + question.text;
+            if (!filter) {
+                row += string(" | Status: ") + statusName(question.status);
+            }
+            body.setLine(line + 1, row);
+        }
+        body.clearFrom(line + 1);
+        screen.status().setLine(0, "Up/Down, PgUp/PgDn, Home/End to scroll - ESC to return", A_REVERSE);
+    }
+};
+
+#endif // LIST_VIEW_H
@@ -1,12 +1,94 @@
 #ifndef QUESTION_H
 #define QUESTION_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
+
+// Question status, stored as a small integer in the questions table.
+// The numeric values are persisted, so only ever append new statuses.
+enum class Status : uint8_t {
+    Submitted = 0,
+    UnderReview = 1,
+    NotUnderstood = 2,
+};
+
+constexpr size_t STATUS_COUNT = 3;
+
+// Questions in these statuses are in the review queue; Submitted ones are not.
+inline bool inReview(Status status) {
+    return status == Status::UnderReview || status == Status::NotUnderstood;
+}
+
+inline const char* statusName(Status status) {
+    switch (status) {
+        case Status::Submitted: return "Submitted";
+        case Status::UnderReview: return "Under Review";
+        case Status::NotUnderstood: return "Not Understood";
+    }
+    return "Unknown";
+}
+
+// Accepts the display names above; returns false for anything else.
+inline bool parseStatus(const std::string& name, Status& status) {
+    for (size_t i = 0; i < STATUS_COUNT; ++i) {
+        if (name == statusName(static_cast<Status>(i))) {
+            status = static_cast<Status>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Lenient form for command-line and file input: letter case, spaces, '-' and
+// '_' are ignored ("under-review" == "Under Review"), and the numeric value is
+// accepted as well as the name.
+inline bool parseStatusArgument(const std::string& text, Status& status) {
+    auto normalize = [](const std::string& name) {
+        std::string key;
+        for (char c : name) {
+            if (c != ' ' && c != '-' && c != '_') {
+                key += (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+            }
+        }
+        return key;
+    };
+    std::string key = normalize(text);
+    if (key.size() == 1 && key[0] >= '0' && key[0] < static_cast<char>('0' + STATUS_COUNT)) {
+        status = static_cast<Status>(key[0] - '0');
+        return true;
+    }
+    for (size_t i = 0; i < STATUS_COUNT; ++i) {
+        if (!key.empty() && key == normalize(statusName(static_cast<Status>(i)))) {
+            status = static_cast<Status>(i);
+            return true;
+        }
+    }
+    return false;
+}
 
 struct Question {
     std::string text;
-    std::string status; // Status can be "Submitted", "Under Review", or "Not Understood"
-    std::string number; // Question number
+    Status status = Status::Submitted; // Status can be Submitted, Under Review, or Not Understood
+    int number = 0;     // Question number (INTEGER PRIMARY KEY in the questions table)
+    long long due = 0;  // Unix time the next review is due; 0 when not in the review queue
+    int interval = 0;   // Days between the last two reviews
 };
 
+// A question row borrowed from the database. text points into SQLite's row
+// buffer and is only valid until the visitor it was passed to returns.
+struct QuestionView {
+    int number = 0;
+    std::string_view text;
+    Status status = Status::Submitted;
+    long long due = 0;
+    int interval = 0;
+};
+
+// Copies a borrowed row into a Question that outlives its source.
+inline Question ownedCopy(const QuestionView& view) {
+    return {std::string(view.text), view.status, view.number, view.due, view.interval};
+}
+
 #endif // QUESTION_H
@@ -0,0 +1,652 @@
+#ifndef QUESTION_CACHE_H
+#define QUESTION_CACHE_H
+
+#include <array>
+#include <ctime>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "bitmap.h"         // Include the compressed number bitmaps
+#include "database.cpp"     // Include the Database class
+#include "db_worker.h"      // Include the background database worker
+#include "question.h"       // Include the Question struct definition
+#include "question_index.h" // Include the number index
+#include "question_store.h" // Include the columnar row storage
+#include "review_queue.h"   // Include the review schedule heap
+#include "snapshot.h"       // Include the memory-mapped startup snapshot
+#include "tag_filter.h"     // Include tag parsing and filter queries
+#include "title_index.h"    // Include the fuzzy title index
+
+// Write-through cache of the questions table.
+// Every mutation is written to SQLite first and, once it succeeds, applied to the
+// in-memory rows, so the TUI never has to re-run SELECT * after its own changes.
+// Changes committed by other connections or processes are noticed through
+// PRAGMA data_version and applied row by row from the database's change log.
+// Rows are kept column by column in a QuestionStore, in no particular order;
+// the QuestionIndex gives numeric order. Readers get QuestionViews that borrow
+// from the store and stay valid until the cache next changes. A running count
+// per status makes counting O(1), and status filters scan one byte per row. A trigram
+// index over the titles is built on the first fuzzy search and kept in step
+// with every change after that. Questions in the review queue are mirrored in
+// a ReviewQueue heap, so the next one due is always at hand. Every question,
+// every status and every tag has a compressed bitmap of question numbers, and
+// filter queries such as "dp and graph and not submitted" combine those.
+//
+// At startup the rows can come from a snapshot file written on the previous
+// clean exit instead of the table; the first refresh then replays only what
+// the change log holds past the snapshot.
+//
+// With a DatabaseWorker attached, mutations are applied to memory right away and
+// written in the background instead; poll() applies the worker's confirmations,
+// and a failed write marks the cache stale so the next refresh reconciles it.
+class QuestionCache {
+public:
+    explicit QuestionCache(Database& database) : db(database) {}
+
+    void attachWorker(DatabaseWorker* databaseWorker) {
+        worker = databaseWorker;
+    }
+
+    // Applies finished background writes. Cheap enough to call every frame.
+    void poll() {
+        if (worker) {
+            worker->poll();
+        }
+    }
+
+    // Number of background writes that failed since the last call.
+    size_t takeFailedWrites() {
+        size_t failed = failedWrites;
+        failedWrites = 0;
+        return failed;
+    }
+
+    // Brings memory up to date if another connection has committed since the
+    // last refresh. The rows touched since then are read back from the change
+    // log; only a first load, a failed background write or a log trimmed past
+    // our position reads the whole table. A read that fails (say, a lock held
+    // too long by another process) leaves memory as it was for the next call
+    // to retry. Returns true if anything in memory changed.
+    bool refreshIfChanged() {
+        poll();
+        if (worker && worker->pending() > 0) {
+            return false; // Our own writes are still landing; memory is ahead of the table
+        }
+        long long version = db.dataVersion();
+        if (version < 0 || (loaded && !stale && version == dataVersion)) {
+            return false;
+        }
+        bool changed;
+        long long applied = loaded && !stale ? applyChanges() : -1;
+        if (applied >= 0) {
+            changed = applied > 0;
+        } else if (reload()) {
+            changed = true;
+        } else {
+            return false;
+        }
+        // Commits from the worker's connection move data_version too; replaying
+        // them rewrites rows with the values memory already holds.
+        dataVersion = version;
+        stale = false;
+        return changed;
+    }
+
+    // Fills an empty cache from a snapshot written by saveSnapshot(). Tags are
+    // not in the file; they are read from the database. The next refresh
+    // brings it up to date from the change log, or reads the whole table if
+    // the log no longer reaches back to the snapshot. Returns false, leaving
+    // the cache empty, if the file is missing, invalid or holds another user's
+    // questions, or the tags could not be read.
+    bool loadSnapshot(const string& path) {
+        TRACK_LATENCY("QuestionCache::loadSnapshot");
+        QuestionSnapshot snapshot;
+        if (loaded || !snapshot.open(path) || snapshot.user() != db.user()) {
+            return false;
+        }
+        size_t count = snapshot.size();
+        QuestionStore loadedRows;
+        loadedRows.reserve(count, snapshot.textBytes());
+        vector<IndexEntry> entries(count);
+        vector<ReviewQueue::Entry> queued;
+        array<size_t, STATUS_COUNT> counts{};
+        array<Bitmap, STATUS_COUNT> statuses;
+        Bitmap numbers;
+        for (size_t i = 0; i < count; ++i) {
+            if (snapshot.status(i) >= STATUS_COUNT || (i > 0 && snapshot.number(i) <= snapshot.number(i - 1))) {
+                return false; // Written by something else; the table is the authority
+            }
+            Status status = static_cast<Status>(snapshot.status(i));
+            entries[i] = {snapshot.number(i), loadedRows.append(snapshot.number(i), snapshot.text(i), status)};
+            counts[snapshot.status(i)]++;
+            statuses[snapshot.status(i)].add(snapshot.number(i));
+            numbers.add(snapshot.number(i));
+            if (snapshot.due(i) > 0) {
+                queued.push_back({snapshot.due(i), snapshot.number(i), snapshot.interval(i)});
+            }
+        }
+        // Read after the snapshot's change log position, so replaying past it
+        // can only bring tags up to date again
+        map<string, Bitmap> tags;
+        if (!readTags(tags)) {
+            return false;
+        }
+        rows = std::move(loadedRows);
+        statusCounts = counts;
+        statusBits = std::move(statuses);
+        everyQuestion = std::move(numbers);
+        tagged = std::move(tags);
+        index.build(std::move(entries)); // Already in number order
+        reviews.build(std::move(queued));
+        changeSequence = snapshot.sequence();
+        dataVersion = -1; // Forces the next refresh to look at the change log
+        loaded = true;
+        return true;
+    }
+
+    // Writes memory to a snapshot for the next startup. Refuses, returning
+    // false, while memory may differ from the table: before the first load,
+    // with background writes in flight or after one failed. Call
+    // refreshIfChanged() first so the recorded change log position is current.
+    bool saveSnapshot(const string& path) {
+        TRACK_LATENCY("QuestionCache::saveSnapshot");
+        if (!loaded || stale || (worker && worker->pending() > 0)) {
+            return false;
+        }
+        vector<QuestionView> ordered;
+        ordered.reserve(rows.size());
+        forEachOrdered([&](const QuestionView& question) { ordered.push_back(scheduled(question)); });
+        return QuestionSnapshot::write(path, db.user(), changeSequence, ordered);
+    }
+
+    bool empty() const {
+        return rows.empty();
+    }
+
+    size_t size() const {
+        return rows.size();
+    }
+
+    size_t count(Status status) const {
+        return statusCounts[static_cast<size_t>(status)];
+    }
+
+    optional<QuestionView> find(int number) const {
+        const IndexEntry* entry = index.find(number);
+        return entry ? optional<QuestionView>(rows.view(entry->slot)) : nullopt;
+    }
+
+    // First question whose number is >= the given one, or nothing past the end.
+    optional<QuestionView> jumpTo(int number) const {
+        auto it = index.lowerBound(number);
+        return it == index.end() ? nullopt : optional<QuestionView>(rows.view(it->slot));
+    }
+
+    // Calls visit(question) for every question in numeric order.
+    template <typename Visitor>
+    void forEachOrdered(Visitor visit) const {
+        for (const IndexEntry& entry : index) {
+            visit(rows.view(entry.slot));
+        }
+    }
+
+    // Calls visit(question) for every question with the given status, in numeric order.
+    template <typename Visitor>
+    void forEachWithStatus(Status status, Visitor visit) const {
+        const vector<Status>& statuses = rows.statuses();
+        vector<uint32_t> matches;
+        matches.reserve(count(status));
+        for (size_t slot = 0; slot < statuses.size(); ++slot) {
+            if (statuses[slot] == status) {
+                matches.push_back(static_cast<uint32_t>(slot));
+            }
+        }
+        sort(matches.begin(), matches.end(), [this](uint32_t a, uint32_t b) {
+            return rows.number(a) < rows.number(b);
+        });
+        for (uint32_t slot : matches) {
+            visit(rows.view(slot));
+        }
+    }
+
+    // Calls visit(question) for low <= number <= high, in numeric order.
+    template <typename Visitor>
+    void forEachInRange(int low, int high, Visitor visit) const {
+        auto bounds = index.range(low, high);
+        for (auto it = bounds.first; it != bounds.second; ++it) {
+            visit(rows.view(it->slot));
+        }
+    }
+
+    // Keyset pages as Database::pageAfter() and pageBefore(), read through
+    // readThrough() so writes still queued on the worker are listed.
+    vector<Question> pageAfter(long long after, int limit, optional<Status> filter = nullopt) {
+        return readThrough([&](Database& target) { return target.pageAfter(after, limit, filter); });
+    }
+
+    vector<Question> pageBefore(long long before, int limit, optional<Status> filter = nullopt) {
+        return readThrough([&](Database& target) { return target.pageBefore(before, limit, filter); });
+    }
+
+    // Full-text search as Database::searchText(), through readThrough().
+    // Returns false if cancelled.
+    bool searchText(const string& query, int limit, vector<Question>& results, const function<bool()>& cancelled) {
+        return readThrough([&](Database& target) { return target.searchText(query, limit, results, cancelled); });
+    }
+
+    // Questions whose title matches the query despite typos, closest first.
+    vector<QuestionView> searchTitles(const string& query, size_t limit) {
+        TRACK_LATENCY("QuestionCache::searchTitles");
+        if (!titlesIndexed) {
+            for (size_t slot = 0; slot < rows.size(); ++slot) {
+                titles.insert(rows.number(slot), rows.text(slot));
+            }
+            titlesIndexed = true;
+        }
+        vector<QuestionView> found;
+        for (const TitleMatch& match : titles.search(query, limit)) {
+            if (optional<QuestionView> question = find(match.number)) {
+                found.push_back(*question);
+            }
+        }
+        return found;
+    }
+
+    // The earliest-due questions in the review queue, overdue ones first,
+    // with their schedule filled in.
+    vector<QuestionView> nextDue(size_t limit) const {
+        TRACK_LATENCY("QuestionCache::nextDue");
+        vector<QuestionView> due;
+        for (const ReviewQueue::Entry& entry : reviews.earliest(limit)) {
+            if (optional<QuestionView> question = find(entry.number)) {
+                due.push_back(scheduled(*question));
+            }
+        }
+        return due;
+    }
+
+    // Questions in the review queue, and how many of them are due by now.
+    size_t queued() const {
+        return reviews.size();
+    }
+
+    size_t dueCount(long long now) const {
+        return reviews.dueBy(now);
+    }
+
+    // Heap bytes held by the rows themselves, the number index, the review
+    // queue and the status and tag bitmaps.
+    size_t rowBytes() const {
+        size_t bitmaps = everyQuestion.memoryBytes();
+        for (const Bitmap& bits : statusBits) {
+            bitmaps += bits.memoryBytes();
+        }
+        for (const auto& [tag, bits] : tagged) {
+            bitmaps += tag.capacity() + bits.memoryBytes();
+        }
+        return rows.memoryBytes() + index.memoryBytes() + reviews.memoryBytes() + bitmaps;
+    }
+
+    // Tags of one question, in name order.
+    vector<string> tagsOf(int number) const {
+        vector<string> tags;
+        for (const auto& [tag, bits] : tagged) {
+            if (bits.contains(static_cast<uint32_t>(number))) {
+                tags.push_back(tag);
+            }
+        }
+        return tags;
+    }
+
+    // Every tag in use with its number of questions, in name order.
+    vector<pair<string, size_t>> tagCounts() const {
+        vector<pair<string, size_t>> counts;
+        for (const auto& [tag, bits] : tagged) {
+            counts.emplace_back(tag, bits.cardinality());
+        }
+        return counts;
+    }
+
+    // Numbers of the questions matching a filter query (see FilterQuery), in
+    // ascending order. Returns false with a message in error if the query is
+    // malformed or names a tag no question has.
+    bool filter(const string& query, Bitmap& result, string& error) const {
+        TRACK_LATENCY("QuestionCache::filter");
+        FilterQuery parsed(query, everyQuestion, [this](const string& word) -> const Bitmap* {
+            Status status;
+            if (parseStatusArgument(word, status)) {
+                return &statusBits[static_cast<size_t>(status)];
+            }
+            auto it = tagged.find(word);
+            return it == tagged.end() ? nullptr : &it->second;
+        });
+        return parsed.evaluate(result, error);
+    }
+
+    // Approximate memory held by the title index; zero until the first search.
+    size_t titleIndexBytes() const {
+        return titlesIndexed ? titles.memoryBytes() : 0;
+    }
+
+    bool add(int number, const string& text, Status status) {
+        if (index.find(number) || !write([=](Database& target) { return target.addQuestion(number, text, status); })) {
+            return false;
+        }
+        insertRow(number, text, status, inReview(status) ? time(nullptr) : 0, 0); // As addQuestion schedules it
+        return true;
+    }
+
+    bool updateStatus(int number, Status status) {
+        if (!write([=](Database& target) { return target.updateQuestionInDB(number, status); })) {
+            return false;
+        }
+        if (const IndexEntry* entry = index.find(number)) {
+            setRowStatus(entry->slot, status);
+            // Joins or leaves the review queue as updateQuestionInDB decides
+            if (!inReview(status)) {
+                reviews.erase(number);
+            } else if (!reviews.find(number)) {
+                reviews.schedule(number, time(nullptr), 0);
+            }
+        }
+        return true;
+    }
+
+    // Records how reviewing a question went at now and reschedules it.
+    bool recordReview(int number, ReviewOutcome outcome, long long now) {
+        const IndexEntry* entry = index.find(number);
+        if (!entry) {
+            return false;
+        }
+        const ReviewQueue::Entry* queued = reviews.find(number);
+        ReviewResult result = scheduleAfter(outcome, queued ? queued->interval : 0, now);
+        if (!write([=](Database& target) {
+                return target.scheduleReview(number, result.status, result.due, result.interval);
+            })) {
+            return false;
+        }
+        setRowStatus(index.find(number)->slot, result.status);
+        if (result.due > 0) {
+            reviews.schedule(number, result.due, result.interval);
+        } else {
+            reviews.erase(number);
+        }
+        return true;
+    }
+
+    // Replaces the tags of a question; tags should come from parseTagList().
+    bool setTags(int number, const vector<string>& tags) {
+        if (!index.find(number) || !write([=](Database& target) { return target.setQuestionTags(number, tags); })) {
+            return false;
+        }
+        retag(number, tags);
+        return true;
+    }
+
+    bool remove(int number) {
+        if (!write([=](Database& target) { return target.deleteQuestionFromDB(number); })) {
+            return false;
+        }
+        eraseRow(number);
+        return true;
+    }
+
+    bool removeAll() {
+        if (!write([](Database& target) { return target.deleteAllQuestionsFromDB(); })) {
+            return false;
+        }
+        rows.clear();
+        statusCounts.fill(0);
+        index.clear();
+        titles.clear();
+        reviews.clear();
+        for (Bitmap& bits : statusBits) {
+            bits.clear();
+        }
+        everyQuestion.clear();
+        tagged.clear();
+        return true;
+    }
+
+private:
+    Database& db;
+    DatabaseWorker* worker = nullptr;
+    QuestionStore rows;                      // Cached questions, in no particular order
+    QuestionIndex index;                     // Question number -> slot in rows
+    TitleIndex titles;                       // Trigrams of every title, once titlesIndexed
+    ReviewQueue reviews;                     // Schedule of the questions in the review queue
+    bool titlesIndexed = false;
+    array<size_t, STATUS_COUNT> statusCounts{}; // Number of rows per status
+    array<Bitmap, STATUS_COUNT> statusBits;  // Question numbers per status
+    Bitmap everyQuestion;                    // Every question number, the universe of NOT
+    map<string, Bitmap> tagged;              // Question numbers per tag, only tags in use
+    long long dataVersion = -1;              // PRAGMA data_version seen at the last refresh
+    long long changeSequence = 0;            // Change log position memory reflects
+    bool loaded = false;
+    bool stale = false;                      // A background write failed; memory may be ahead of the table
+    size_t failedWrites = 0;
+
+    // Runs a write synchronously, or hands it to the worker and reports success
+    // optimistically; the caller then applies the change to memory.
+    bool write(DatabaseWorker::Job job) {
+        if (!worker) {
+            return job(db);
+        }
+        worker->submit(std::move(job), [this](bool ok) {
+            if (!ok) {
+                failedWrites++;
+                stale = true;
+            }
+        });
+        return true;
+    }
+
+    // Runs a read on the connection that holds our writes: the worker's, after
+    // the jobs queued there (committed or not), or our own without a worker.
+    template <typename Read>
+    auto readThrough(Read read) -> decltype(read(db)) {
+        if (!worker) {
+            return read(db);
+        }
+        decltype(read(db)) result{};
+        worker->call([&](Database& target) {
+            result = read(target);
+            return true;
+        });
+        return result;
+    }
+
+    // The question with its review schedule, which the store does not keep.
+    QuestionView scheduled(QuestionView question) const {
+        if (const ReviewQueue::Entry* entry = reviews.find(question.number)) {
+            question.due = entry->due;
+            question.interval = entry->interval;
+        }
+        return question;
+    }
+
+    void insertRow(int number, const string& text, Status status, long long due, int interval) {
+        if (titlesIndexed) {
+            titles.insert(number, text);
+        }
+        index.insert(number, rows.append(number, text, status));
+        statusCounts[static_cast<size_t>(status)]++;
+        statusBits[static_cast<size_t>(status)].add(number);
+        everyQuestion.add(number);
+        if (due > 0) {
+            reviews.schedule(number, due, interval);
+        }
+    }
+
+    void eraseRow(int number) {
+        const IndexEntry* entry = index.find(number);
+        if (!entry) {
+            return;
+        }
+        // Swap the last row into the freed slot so removal only moves one row
+        uint32_t slot = entry->slot;
+        index.erase(number);
+        titles.erase(number);
+        reviews.erase(number);
+        retag(number, {});
+        statusCounts[static_cast<size_t>(rows.status(slot))]--;
+        statusBits[static_cast<size_t>(rows.status(slot))].remove(number);
+        everyQuestion.remove(number);
+        if (rows.removeSwap(slot)) {
+            index.relocate(rows.number(slot), slot);
+        }
+    }
+
+    // Moves a row to another status, keeping the counts and bitmaps in step.
+    void setRowStatus(uint32_t slot, Status status) {
+        Status old = rows.status(slot);
+        if (old == status) {
+            return;
+        }
+        int number = rows.number(slot);
+        statusCounts[static_cast<size_t>(old)]--;
+        statusCounts[static_cast<size_t>(status)]++;
+        statusBits[static_cast<size_t>(old)].remove(number);
+        statusBits[static_cast<size_t>(status)].add(number);
+        rows.setStatus(slot, status);
+    }
+
+    // Gives a question exactly the given tags, which must be sorted. Bitmaps
+    // of tags no question has any more are dropped.
+    void retag(int number, const vector<string>& tags) {
+        for (auto it = tagged.begin(); it != tagged.end();) {
+            if (!binary_search(tags.begin(), tags.end(), it->first) && it->second.remove(number) &&
+                it->second.empty()) {
+                it = tagged.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        for (const string& tag : tags) {
+            tagged[tag].add(number);
+        }
+    }
+
+    // Reads every tag's questions into fresh bitmaps. Returns false on a
+    // database error.
+    bool readTags(map<string, Bitmap>& tags) {
+        Bitmap* current = nullptr;
+        string currentTag;
+        return db.forEachTagging([&](string_view tag, int number) {
+            if (!current || tag != currentTag) {
+                currentTag = tag;
+                current = &tags[currentTag];
+            }
+            current->add(number); // Each tag's numbers arrive in order, so these append
+        });
+    }
+
+    // Applies the rows changed since changeSequence. Returns how many rows
+    // changed in memory, or -1 if a full reload is needed instead: the log
+    // could not be read, or so much changed that rebuilding the index is cheaper
+    // than inserting into it row by row.
+    long long applyChanges() {
+        struct Change {
+            int number;
+            optional<Question> question;
+            vector<string> tags;
+        };
+        vector<Change> changes;
+        long long sequence = changeSequence;
+        bool complete = db.changesSince(sequence, [&](int number, const Question* question,
+                                                      const vector<string>& tags) {
+            changes.push_back({number, question ? optional<Question>(*question) : nullopt, tags});
+        });
+        if (!complete || changes.size() > max<size_t>(1024, rows.size() / 4)) {
+            return -1;
+        }
+        long long changed = 0;
+        for (auto& [number, question, tags] : changes) {
+            const IndexEntry* entry = index.find(number);
+            if (!question) {
+                changed += entry ? 1 : 0;
+                eraseRow(number);
+                continue;
+            }
+            if (!entry) {
+                insertRow(number, question->text, question->status, question->due, question->interval);
+                retag(number, tags);
+                changed++;
+                continue;
+            }
+            bool rowChanged = tagsOf(number) != tags;
+            if (rowChanged) {
+                retag(number, tags);
+            }
+            if (rows.text(entry->slot) != question->text || rows.status(entry->slot) != question->status ||
+                !sameSchedule(number, *question)) {
+                uint32_t slot = entry->slot;
+                if (question->due > 0) {
+                    reviews.schedule(number, question->due, question->interval);
+                } else {
+                    reviews.erase(number);
+                }
+                if (rows.text(slot) != question->text) {
+                    if (titlesIndexed) {
+                        titles.insert(number, question->text);
+                    }
+                    rows.setText(slot, question->text);
+                }
+                setRowStatus(slot, question->status);
+                rowChanged = true;
+            }
+            changed += rowChanged ? 1 : 0;
+        }
+        changeSequence = sequence;
+        return changed;
+    }
+
+    // Whether the review queue already holds the row's schedule.
+    bool sameSchedule(int number, const Question& question) const {
+        const ReviewQueue::Entry* entry = reviews.find(number);
+        return entry ? entry->due == question.due && entry->interval == question.interval : question.due == 0;
+    }
+
+    // Reads every row again. Returns false, keeping what memory holds, if the
+    // table could not be read.
+    bool reload() {
+        QuestionStore loadedRows;
+        vector<IndexEntry> entries;
+        vector<ReviewQueue::Entry> queued;
+        array<size_t, STATUS_COUNT> counts{};
+        array<Bitmap, STATUS_COUNT> statuses;
+        Bitmap numbers;
+        map<string, Bitmap> tags;
+        long long sequence = 0;
+        bool ok = db.loadQuestions([&](const QuestionView& question) {
+            entries.push_back({question.number, loadedRows.append(question.number, question.text, question.status)});
+            counts[static_cast<size_t>(question.status)]++;
+            statuses[static_cast<size_t>(question.status)].add(question.number); // In number order, so these append
+            numbers.add(question.number);
+            if (question.due > 0) {
+                queued.push_back({question.due, question.number, question.interval});
+            }
+        }, sequence);
+        // Tags read after sequence are at least as new; replaying past it re-reads them
+        if (!ok || !readTags(tags)) {
+            return false;
+        }
+        loadedRows.shrinkToFit();
+        rows = std::move(loadedRows);
+        changeSequence = sequence;
+        statusCounts = counts;
+        statusBits = std::move(statuses);
+        everyQuestion = std::move(numbers);
+        tagged = std::move(tags);
+        index.build(std::move(entries)); // Already in number order
+        reviews.build(std::move(queued));
+        titles.clear(); // Rebuilt on the next fuzzy search
+        titlesIndexed = false;
+        loaded = true;
+        return true;
+    }
+};
+
+#endif // QUESTION_CACHE_H
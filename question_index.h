@@ -0,0 +1,274 @@
+#ifndef QUESTION_INDEX_H
+#define QUESTION_INDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Parses a question number such as "1042". Rejects empty input, signs,
+// non-digit characters and values that do not fit in an int.
+inline bool parseQuestionNumber(const std::string& text, int& number) {
+    if (text.empty()) {
+        return false;
+    }
+    for (char c : text) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+    }
+    errno = 0;
+    long value = std::strtol(text.c_str(), nullptr, 10);
+    if (errno == ERANGE || value > INT_MAX) {
+        return false;
+    }
+    number = static_cast<int>(value);
+    return true;
+}
+
+struct IndexEntry {
+    int number;    // Parsed question number (the key)
+    uint32_t slot; // Position of the row in the owning cache
+};
+
+// Sorted (number, slot) pairs, split into blocks of at most BLOCK_LIMIT
+// entries, with the first number of every block in a directory.
+// Eight bytes per entry in a few contiguous blocks: point lookups and "jump to"
+// are a binary search over the directory then within one block, range queries
+// add a linear walk, and an in-order walk visits questions in numeric order.
+// Adding or removing a number moves at most one block's entries (plus, when a
+// block splits or empties, the directory), instead of half the index.
+class QuestionIndex {
+public:
+    // Walks entries in numeric order across blocks.
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = IndexEntry;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const IndexEntry*;
+        using reference = const IndexEntry&;
+
+        const_iterator() = default;
+
+        reference operator*() const { return (*blocks)[block][position]; }
+        pointer operator->() const { return &(*blocks)[block][position]; }
+
+        const_iterator& operator++() {
+            if (++position == (*blocks)[block].size()) {
+                block++;
+                position = 0;
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator before = *this;
+            ++*this;
+            return before;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return block == other.block && position == other.position;
+        }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+    private:
+        friend class QuestionIndex;
+        const std::vector<std::vector<IndexEntry>>* blocks = nullptr;
+        size_t block = 0;    // blocks->size() at the end
+        size_t position = 0; // Always within the block, 0 at the end
+
+        const_iterator(const std::vector<std::vector<IndexEntry>>* owner, size_t blockIndex, size_t offset)
+            : blocks(owner), block(blockIndex), position(offset) {
+            if (block < blocks->size() && position == (*blocks)[block].size()) {
+                block++;
+                position = 0;
+            }
+        }
+    };
+
+    void clear() {
+        blocks.clear();
+        firstNumbers.clear();
+        count = 0;
+    }
+
+    // Replaces the contents with the given entries, sorting them once.
+    void build(std::vector<IndexEntry> unsorted) {
+        auto byNumber = [](const IndexEntry& a, const IndexEntry& b) { return a.number < b.number; };
+        if (!std::is_sorted(unsorted.begin(), unsorted.end(), byNumber)) { // Loads arrive in number order
+            std::sort(unsorted.begin(), unsorted.end(), byNumber);
+        }
+        clear();
+        // Half-full blocks leave room to add numbers before the first split
+        const size_t fill = BLOCK_LIMIT / 2;
+        for (size_t first = 0; first < unsorted.size(); first += fill) {
+            size_t last = std::min(first + fill, unsorted.size());
+            blocks.emplace_back(unsorted.begin() + first, unsorted.begin() + last);
+            firstNumbers.push_back(unsorted[first].number);
+        }
+        count = unsorted.size();
+    }
+
+    // Returns false if the number is already present.
+    bool insert(int number, uint32_t slot) {
+        if (blocks.empty()) {
+            blocks.push_back({{number, slot}});
+            firstNumbers.push_back(number);
+            count = 1;
+            return true;
+        }
+        size_t block = blockFor(number);
+        std::vector<IndexEntry>& entries = blocks[block];
+        auto it = lowerBoundIn(entries, number);
+        if (it != entries.end() && it->number == number) {
+            return false;
+        }
+        entries.insert(it, {number, slot});
+        firstNumbers[block] = entries.front().number;
+        count++;
+        if (entries.size() > BLOCK_LIMIT) {
+            split(block);
+        }
+        return true;
+    }
+
+    bool erase(int number) {
+        if (blocks.empty()) {
+            return false;
+        }
+        size_t block = blockFor(number);
+        std::vector<IndexEntry>& entries = blocks[block];
+        auto it = lowerBoundIn(entries, number);
+        if (it == entries.end() || it->number != number) {
+            return false;
+        }
+        entries.erase(it);
+        count--;
+        if (entries.empty()) {
+            blocks.erase(blocks.begin() + block);
+            firstNumbers.erase(firstNumbers.begin() + block);
+            return true;
+        }
+        firstNumbers[block] = entries.front().number;
+        if (entries.size() < BLOCK_LIMIT / 4) {
+            mergeSmall(block);
+        }
+        return true;
+    }
+
+    // Points an existing key at a new slot, e.g. after the cache moved a row.
+    void relocate(int number, uint32_t slot) {
+        if (blocks.empty()) {
+            return;
+        }
+        std::vector<IndexEntry>& entries = blocks[blockFor(number)];
+        auto it = lowerBoundIn(entries, number);
+        if (it != entries.end() && it->number == number) {
+            it->slot = slot;
+        }
+    }
+
+    const IndexEntry* find(int number) const {
+        if (blocks.empty()) {
+            return nullptr;
+        }
+        const std::vector<IndexEntry>& entries = blocks[blockFor(number)];
+        auto it = std::lower_bound(entries.begin(), entries.end(), number,
+                                   [](const IndexEntry& entry, int key) { return entry.number < key; });
+        if (it == entries.end() || it->number != number) {
+            return nullptr;
+        }
+        return &*it;
+    }
+
+    // First entry whose number is >= the given number ("jump to number").
+    const_iterator lowerBound(int number) const {
+        if (blocks.empty()) {
+            return end();
+        }
+        size_t block = blockFor(number);
+        const std::vector<IndexEntry>& entries = blocks[block];
+        auto it = std::lower_bound(entries.begin(), entries.end(), number,
+                                   [](const IndexEntry& entry, int key) { return entry.number < key; });
+        return const_iterator(&blocks, block, static_cast<size_t>(it - entries.begin()));
+    }
+
+    // Entries with low <= number <= high, in numeric order.
+    std::pair<const_iterator, const_iterator> range(int low, int high) const {
+        if (low > high || blocks.empty()) {
+            return {end(), end()};
+        }
+        size_t block = blockFor(high);
+        const std::vector<IndexEntry>& entries = blocks[block];
+        auto last = std::upper_bound(entries.begin(), entries.end(), high,
+                                     [](int key, const IndexEntry& entry) { return key < entry.number; });
+        return {lowerBound(low), const_iterator(&blocks, block, static_cast<size_t>(last - entries.begin()))};
+    }
+
+    const_iterator begin() const { return const_iterator(&blocks, 0, 0); }
+    const_iterator end() const { return const_iterator(&blocks, blocks.size(), 0); }
+    size_t size() const { return count; }
+
+    size_t memoryBytes() const {
+        size_t bytes = blocks.capacity() * sizeof(std::vector<IndexEntry>) + firstNumbers.capacity() * sizeof(int);
+        for (const std::vector<IndexEntry>& entries : blocks) {
+            bytes += entries.capacity() * sizeof(IndexEntry);
+        }
+        return bytes;
+    }
+
+private:
+    // 8 KiB blocks: updates memmove at most this much, and the directory of a
+    // million questions has a few thousand entries.
+    static constexpr size_t BLOCK_LIMIT = 1024;
+
+    std::vector<std::vector<IndexEntry>> blocks; // Sorted, non-empty, no duplicates
+    std::vector<int> firstNumbers;               // firstNumbers[i] == blocks[i].front().number
+    size_t count = 0;
+
+    // The block that holds the number if present: the last one starting at
+    // or before it, or the first block for numbers below every key.
+    size_t blockFor(int number) const {
+        auto it = std::upper_bound(firstNumbers.begin(), firstNumbers.end(), number);
+        return it == firstNumbers.begin() ? 0 : static_cast<size_t>(it - firstNumbers.begin()) - 1;
+    }
+
+    static std::vector<IndexEntry>::iterator lowerBoundIn(std::vector<IndexEntry>& entries, int number) {
+        return std::lower_bound(entries.begin(), entries.end(), number,
+                                [](const IndexEntry& entry, int key) { return entry.number < key; });
+    }
+
+    // Moves the upper half of an overfull block into a new block after it.
+    void split(size_t block) {
+        std::vector<IndexEntry>& entries = blocks[block];
+        std::vector<IndexEntry> upper(entries.begin() + entries.size() / 2, entries.end());
+        entries.resize(entries.size() / 2);
+        int first = upper.front().number;
+        blocks.insert(blocks.begin() + block + 1, std::move(upper));
+        firstNumbers.insert(firstNumbers.begin() + block + 1, first);
+    }
+
+    // Folds a block that removals shrank into a neighbour, if the two fit in
+    // one block, so lookups do not slow down as blocks thin out.
+    void mergeSmall(size_t block) {
+        if (blocks.size() == 1) {
+            return;
+        }
+        size_t left = block + 1 < blocks.size() ? block : block - 1;
+        if (blocks[left].size() + blocks[left + 1].size() > BLOCK_LIMIT) {
+            return;
+        }
+        blocks[left].insert(blocks[left].end(), blocks[left + 1].begin(), blocks[left + 1].end());
+        blocks.erase(blocks.begin() + left + 1);
+        firstNumbers.erase(firstNumbers.begin() + left + 1);
+    }
+};
+
+#endif // QUESTION_INDEX_H
@@ -0,0 +1,162 @@
+#ifndef QUESTION_STORE_H
+#define QUESTION_STORE_H
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "question.h"
+
+// Columnar storage for cached questions: one array of numbers, one of status
+// bytes, and every text packed into a single arena addressed by offset and
+// length. A row costs 13 bytes plus its text, with no allocation of its own,
+// and a status scan walks one byte per row.
+//
+// Rows live in slots; removal swaps the last row into the freed slot. Text
+// that is replaced or removed stays in the arena as garbage until it outweighs
+// the live text, then the arena is compacted. string_views handed out are
+// valid until the store next changes.
+class QuestionStore {
+public:
+    size_t size() const {
+        return numbers.size();
+    }
+
+    bool empty() const {
+        return numbers.empty();
+    }
+
+    void clear() {
+        numbers.clear();
+        statusColumn.clear();
+        spans.clear();
+        arena.clear();
+        garbage = 0;
+    }
+
+    void reserve(size_t rows, size_t textBytes) {
+        numbers.reserve(rows);
+        statusColumn.reserve(rows);
+        spans.reserve(rows);
+        arena.reserve(textBytes);
+    }
+
+    // Gives back spare capacity, e.g. after loading rows of unknown total size.
+    void shrinkToFit() {
+        numbers.shrink_to_fit();
+        statusColumn.shrink_to_fit();
+        spans.shrink_to_fit();
+        arena.shrink_to_fit();
+    }
+
+    int number(size_t slot) const {
+        return numbers[slot];
+    }
+
+    Status status(size_t slot) const {
+        return statusColumn[slot];
+    }
+
+    std::string_view text(size_t slot) const {
+        return std::string_view(arena.data() + spans[slot].offset, spans[slot].length);
+    }
+
+    QuestionView view(size_t slot) const {
+        return {numbers[slot], text(slot), statusColumn[slot]};
+    }
+
+    // The status of every slot, in slot order.
+    const std::vector<Status>& statuses() const {
+        return statusColumn;
+    }
+
+    // Adds a row in the next slot and returns that slot.
+    uint32_t append(int number, std::string_view text, Status status) {
+        uint32_t slot = static_cast<uint32_t>(numbers.size());
+        numbers.push_back(number);
+        statusColumn.push_back(status);
+        spans.push_back(store(text));
+        return slot;
+    }
+
+    void setStatus(size_t slot, Status status) {
+        statusColumn[slot] = status;
+    }
+
+    void setText(size_t slot, std::string_view text) {
+        garbage += spans[slot].length;
+        spans[slot] = store(text);
+        compactIfWasteful();
+    }
+
+    // Frees a slot by moving the last row into it. Returns true if a row moved,
+    // so the caller can update whatever refers to that row by slot.
+    bool removeSwap(size_t slot) {
+        garbage += spans[slot].length;
+        size_t last = numbers.size() - 1;
+        bool moved = slot != last;
+        if (moved) {
+            numbers[slot] = numbers[last];
+            statusColumn[slot] = statusColumn[last];
+            spans[slot] = spans[last];
+        }
+        numbers.pop_back();
+        statusColumn.pop_back();
+        spans.pop_back();
+        compactIfWasteful();
+        return moved;
+    }
+
+    // Heap bytes held, counting reserved capacity.
+    size_t memoryBytes() const {
+        return numbers.capacity() * sizeof(int32_t) + statusColumn.capacity() * sizeof(Status) +
+               spans.capacity() * sizeof(TextSpan) + arena.capacity();
+    }
+
+private:
+    struct TextSpan {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    std::vector<int32_t> numbers;
+    std::vector<Status> statusColumn;
+    std::vector<TextSpan> spans;
+    std::vector<char> arena;
+    size_t garbage = 0; // Arena bytes no row refers to any more
+
+    TextSpan store(std::string_view text) {
+        if (arena.size() + text.size() > UINT32_MAX) {
+            compact();
+            if (arena.size() + text.size() > UINT32_MAX) {
+                throw std::length_error("QuestionStore: question text exceeds 4 GiB");
+            }
+        }
+        TextSpan span{static_cast<uint32_t>(arena.size()), static_cast<uint32_t>(text.size())};
+        arena.insert(arena.end(), text.begin(), text.end());
+        return span;
+    }
+
+    void compactIfWasteful() {
+        if (garbage > 4096 && garbage > arena.size() - garbage) {
+            compact();
+        }
+    }
+
+    // Copies the live text into a fresh arena, in slot order.
+    void compact() {
+        std::vector<char> packed;
+        packed.reserve(arena.size() - garbage);
+        for (TextSpan& span : spans) {
+            uint32_t offset = static_cast<uint32_t>(packed.size());
+            packed.insert(packed.end(), arena.begin() + span.offset, arena.begin() + span.offset + span.length);
+            span.offset = offset;
+        }
+        arena.swap(packed);
+        garbage = 0;
+    }
+};
+
+#endif // QUESTION_STORE_H
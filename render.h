@@ -0,0 +1,317 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <ncurses.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Bytes the calling thread has handed to write(2), from /proc/thread-self/io.
+// Sampled around every terminal update, the difference is exactly what ncurses
+// sent to the terminal; the database worker writes from its own thread.
+class TerminalByteCounter {
+public:
+    TerminalByteCounter() : fd(open("/proc/thread-self/io", O_RDONLY | O_CLOEXEC)) {}
+
+    ~TerminalByteCounter() {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    TerminalByteCounter(const TerminalByteCounter&) = delete;
+    TerminalByteCounter& operator=(const TerminalByteCounter&) = delete;
+
+    bool available() const {
+        return fd >= 0;
+    }
+
+    // Brackets a call that may write to the terminal.
+    void begin() {
+        mark = written();
+    }
+
+    void end() {
+        total += written() - mark;
+    }
+
+    unsigned long long bytes() const {
+        return total;
+    }
+
+private:
+    int fd;
+    unsigned long long mark = 0;
+    unsigned long long total = 0;
+
+    unsigned long long written() {
+        char buffer[256];
+        ssize_t size = fd >= 0 ? pread(fd, buffer, sizeof(buffer) - 1, 0) : -1;
+        if (size <= 0) {
+            return 0;
+        }
+        buffer[size] = '\0';
+        const char* field = strstr(buffer, "wchar:"); // Counts every write(2), not just ones that reach a disk
+        return field ? strtoull(field + 6, nullptr, 10) : 0;
+    }
+};
+
+// A persistent ncurses window that remembers what each of its rows shows.
+// Setting a row to what it already holds costs nothing; changed rows are
+// rewritten and the window is only staged (wnoutrefresh) when something
+// changed, so one doupdate per frame sends just the difference.
+class Pane {
+public:
+    Pane(int height, int width, int y, int x) : win(newwin(height, width, y, x)), rows(height) {
+        keypad(win, TRUE);
+    }
+
+    ~Pane() {
+        delwin(win);
+    }
+
+    Pane(const Pane&) = delete;
+    Pane& operator=(const Pane&) = delete;
+
+    WINDOW* window() const {
+        return win;
+    }
+
+    int height() const {
+        return getmaxy(win);
+    }
+
+    int width() const {
+        return getmaxx(win);
+    }
+
+    // Shows text on the given row from column on, clipped to the window.
+    void setLine(int row, const std::string& text, attr_t attr = A_NORMAL, int column = 0) {
+        if (row < 0 || row >= static_cast<int>(rows.size())) {
+            return;
+        }
+        Row next{text.substr(0, std::max(0, width() - column)), attr, column};
+        if (rows[row] && *rows[row] == next) {
+            return;
+        }
+        wmove(win, row, 0);
+        wclrtoeol(win);
+        wattrset(win, attr);
+        mvwaddnstr(win, row, column, next.text.c_str(), static_cast<int>(next.text.size()));
+        wattrset(win, A_NORMAL);
+        rows[row] = std::move(next);
+        dirty = true;
+    }
+
+    // Blanks every row from the given one down.
+    void clearFrom(int row) {
+        for (int i = std::max(0, row); i < static_cast<int>(rows.size()); ++i) {
+            setLine(i, "");
+        }
+    }
+
+    // Forgets what the rows from the given one down show, after something other
+    // than setLine (such as echoed input) wrote to them.
+    void forget(int row) {
+        for (int i = std::max(0, row); i < static_cast<int>(rows.size()); ++i) {
+            rows[i].reset();
+        }
+    }
+
+    // Where the terminal cursor is left when this pane is staged last.
+    void placeCursor(int row, int column) {
+        cursor = {row, column};
+    }
+
+    // Marks the whole window for repainting, after another window covered it.
+    void touch() {
+        touchwin(win);
+        dirty = true;
+    }
+
+    void resize(int height, int width, int y, int x) {
+        wresize(win, height, width);
+        mvwin(win, y, x);
+        werase(win);
+        rows.assign(height, std::nullopt);
+        dirty = true;
+    }
+
+    // Copies the changed rows to the virtual screen. Nothing reaches the
+    // terminal until doupdate.
+    void stage() {
+        if (cursor) {
+            wmove(win, cursor->first, cursor->second);
+            cursor.reset();
+            dirty = true;
+        }
+        if (dirty) {
+            wnoutrefresh(win);
+            dirty = false;
+        }
+    }
+
+private:
+    struct Row {
+        std::string text;
+        attr_t attr;
+        int column;
+
+        bool operator==(const Row& other) const {
+            return attr == other.attr && column == other.column && text == other.text;
+        }
+    };
+
+    WINDOW* win;
+    std::vector<std::optional<Row>> rows;
+    std::optional<std::pair<int, int>> cursor;
+    bool dirty = true;
+};
+
+// The terminal, split into persistent windows: a body that screens draw into,
+// a one-line status bar along the bottom and a popup shown over both. Screens
+// set rows on the panes and call update(), which batches every changed window
+// into one doupdate. Nothing ever calls clear(), which would resend the whole
+// screen.
+class Screen {
+public:
+    Screen() {
+        initscr();
+        cbreak(); // Disable line buffering
+        noecho(); // Don't echo input
+        keypad(stdscr, TRUE); // Enable special keys
+        mousemask(ALL_MOUSE_EVENTS, NULL); // Enable mouse events
+        bodyPane.emplace(std::max(1, LINES - 1), COLS, 0, 0);
+        statusPane.emplace(1, COLS, std::max(0, LINES - 1), 0);
+    }
+
+    ~Screen() {
+        close();
+    }
+
+    Screen(const Screen&) = delete;
+    Screen& operator=(const Screen&) = delete;
+
+    // Leaves curses mode, restoring the terminal. Safe to call twice.
+    void close() {
+        if (!isendwin()) {
+            popupPane.reset();
+            statusPane.reset();
+            bodyPane.reset();
+            endwin();
+        }
+    }
+
+    Pane& body() {
+        return *bodyPane;
+    }
+
+    Pane& status() {
+        return *statusPane;
+    }
+
+    // Draws options one per row from firstRow down, the selected one highlighted.
+    void drawOptions(int firstRow, const std::vector<std::string>& options, int selected, int column = 0,
+                     bool numbered = false) {
+        for (size_t i = 0; i < options.size(); ++i) {
+            std::string label = numbered ? std::to_string(i + 1) + ". " + options[i] : options[i];
+            body().setLine(firstRow + static_cast<int>(i), label, static_cast<int>(i) == selected ? A_REVERSE : A_NORMAL,
+                           column);
+        }
+    }
+
+    // Sends every change since the last update to the terminal in one write.
+    void update() {
+        bytes.begin();
+        statusPane->stage();
+        bodyPane->stage(); // Leaves the cursor where the body placed it
+        if (popupPane) {
+            popupPane->touch();
+            popupPane->stage(); // Keep the popup above the body
+        }
+        doupdate();
+        bytes.end();
+    }
+
+    // Returns a key ncurses has ready without waiting, or ERR. KEY_RESIZE has
+    // already resized the panes.
+    int pollKey() {
+        update();
+        wtimeout(bodyPane->window(), 0);
+        bytes.begin();
+        int ch = wgetch(bodyPane->window());
+        bytes.end();
+        if (ch == KEY_RESIZE) {
+            resize();
+        }
+        return ch;
+    }
+
+    // Shows a boxed message over the current screen until hidePopup().
+    // Lines are separated by '\n'.
+    void showPopup(const std::string& message) {
+        std::vector<std::string> lines;
+        size_t start = 0;
+        while (true) {
+            size_t newline = message.find('\n', start);
+            lines.push_back(message.substr(start, newline - start));
+            if (newline == std::string::npos) {
+                break;
+            }
+            start = newline + 1;
+        }
+        lines.push_back("");
+        lines.push_back("Press any key to continue...");
+        int width = 0;
+        for (const std::string& line : lines) {
+            width = std::max(width, static_cast<int>(line.size()));
+        }
+        width = std::min(width + 4, COLS);
+        int height = std::min(static_cast<int>(lines.size()) + 2, LINES);
+        int y = std::max(0, (LINES - height) / 2);
+        int x = std::max(0, (COLS - width) / 2);
+        if (!popupPane) {
+            popupPane.emplace(height, width, y, x);
+        } else {
+            popupPane->resize(height, width, y, x);
+        }
+        for (size_t i = 0; i < lines.size(); ++i) {
+            popupPane->setLine(static_cast<int>(i) + 1, lines[i], A_NORMAL, 2);
+        }
+        box(popupPane->window(), 0, 0);
+    }
+
+    void hidePopup() {
+        popupPane.reset();
+        bodyPane->touch(); // Only the cells the popup covered differ from the terminal
+        statusPane->touch();
+    }
+
+    // Bytes sent to the terminal so far, or nullopt where /proc is unavailable.
+    std::optional<unsigned long long> bytesWritten() const {
+        if (!bytes.available()) {
+            return std::nullopt;
+        }
+        return bytes.bytes();
+    }
+
+private:
+    std::optional<Pane> bodyPane;
+    std::optional<Pane> statusPane;
+    std::optional<Pane> popupPane;
+    TerminalByteCounter bytes;
+
+    void resize() {
+        bodyPane->resize(std::max(1, LINES - 1), COLS, 0, 0);
+        statusPane->resize(1, COLS, std::max(0, LINES - 1), 0);
+    }
+};
+
+#endif // RENDER_H
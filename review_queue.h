@@ -0,0 +1,222 @@
+#ifndef REVIEW_QUEUE_H
+#define REVIEW_QUEUE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "question.h"
+
+// How a review went, as recorded on the Review screen.
+enum class ReviewOutcome {
+    Again, // Could not solve it: back to Not Understood, due again tomorrow
+    Good,  // Solved it: the interval doubles
+    Easy,  // Solved it at once: the interval quadruples
+    Done,  // Mastered: marked Submitted, which takes it out of the queue
+};
+
+// Where a review leaves a question.
+struct ReviewResult {
+    Status status;
+    long long due; // 0 when it left the queue
+    int interval;  // Days
+};
+
+// Next schedule for a question reviewed at now whose interval was the given
+// number of days (0 if it was never reviewed). Intervals are capped at a year.
+inline ReviewResult scheduleAfter(ReviewOutcome outcome, int interval, long long now) {
+    const int maxInterval = 365;
+    const long long day = 86400;
+    switch (outcome) {
+        case ReviewOutcome::Again:
+            return {Status::NotUnderstood, now + day, 1};
+        case ReviewOutcome::Good:
+            interval = std::min(maxInterval, std::max(1, interval * 2));
+            return {Status::UnderReview, now + interval * day, interval};
+        case ReviewOutcome::Easy:
+            interval = std::min(maxInterval, std::max(4, interval * 4));
+            return {Status::UnderReview, now + interval * day, interval};
+        case ReviewOutcome::Done:
+            break;
+    }
+    return {Status::Submitted, 0, 0};
+}
+
+// Questions in the review queue, in a binary min-heap ordered by due time
+// (then number), with each question's heap position kept in a hash map.
+// The earliest-due question is always at the top, and scheduling,
+// rescheduling or removing one question costs O(log n).
+class ReviewQueue {
+public:
+    struct Entry {
+        long long due;
+        int number;
+        int interval;
+    };
+
+    size_t size() const {
+        return heap.size();
+    }
+
+    bool empty() const {
+        return heap.empty();
+    }
+
+    void clear() {
+        heap.clear();
+        positions.clear();
+    }
+
+    // Replaces the contents with the given entries in O(n).
+    void build(std::vector<Entry> entries) {
+        heap = std::move(entries);
+        positions.clear();
+        positions.reserve(heap.size());
+        for (size_t i = 0; i < heap.size(); ++i) {
+            positions[heap[i].number] = static_cast<uint32_t>(i);
+        }
+        for (size_t i = heap.size() / 2; i-- > 0;) {
+            siftDown(i);
+        }
+    }
+
+    const Entry* find(int number) const {
+        auto it = positions.find(number);
+        return it == positions.end() ? nullptr : &heap[it->second];
+    }
+
+    // The earliest-due question; the queue must not be empty.
+    const Entry& top() const {
+        return heap.front();
+    }
+
+    // Adds the question, or moves it if it is already queued.
+    void schedule(int number, long long due, int interval) {
+        auto it = positions.find(number);
+        if (it == positions.end()) {
+            heap.push_back({due, number, interval});
+            positions[number] = static_cast<uint32_t>(heap.size() - 1);
+            siftUp(heap.size() - 1);
+            return;
+        }
+        size_t i = it->second;
+        heap[i].due = due;
+        heap[i].interval = interval;
+        siftUp(i);
+        siftDown(positions[number]);
+    }
+
+    void erase(int number) {
+        auto it = positions.find(number);
+        if (it == positions.end()) {
+            return;
+        }
+        size_t i = it->second;
+        positions.erase(it);
+        Entry last = heap.back();
+        heap.pop_back();
+        if (i < heap.size()) {
+            place(i, last);
+            siftUp(i);
+            siftDown(positions[last.number]);
+        }
+    }
+
+    // Up to limit entries in due order, without disturbing the heap. Only the
+    // entries that could come next are looked at: O(limit log limit).
+    std::vector<Entry> earliest(size_t limit) const {
+        std::vector<Entry> result;
+        std::vector<uint32_t> frontier; // Heap positions, itself a min-heap
+        auto later = [this](uint32_t a, uint32_t b) { return before(heap[b], heap[a]); };
+        if (!heap.empty()) {
+            frontier.push_back(0);
+        }
+        while (result.size() < limit && !frontier.empty()) {
+            std::pop_heap(frontier.begin(), frontier.end(), later);
+            uint32_t i = frontier.back();
+            frontier.pop_back();
+            result.push_back(heap[i]);
+            for (size_t child = 2 * size_t(i) + 1; child <= 2 * size_t(i) + 2 && child < heap.size(); ++child) {
+                frontier.push_back(static_cast<uint32_t>(child));
+                std::push_heap(frontier.begin(), frontier.end(), later);
+            }
+        }
+        return result;
+    }
+
+    // How many questions are due at or before now. Walks only those.
+    size_t dueBy(long long now) const {
+        size_t count = 0;
+        std::vector<uint32_t> pending;
+        if (!heap.empty()) {
+            pending.push_back(0);
+        }
+        while (!pending.empty()) {
+            size_t i = pending.back();
+            pending.pop_back();
+            if (heap[i].due > now) {
+                continue; // Everything below is due later still
+            }
+            count++;
+            for (size_t child = 2 * i + 1; child <= 2 * i + 2 && child < heap.size(); ++child) {
+                pending.push_back(static_cast<uint32_t>(child));
+            }
+        }
+        return count;
+    }
+
+    // Approximate heap bytes held, counting the hash map's nodes and buckets.
+    size_t memoryBytes() const {
+        return heap.capacity() * sizeof(Entry) + positions.bucket_count() * sizeof(void*) +
+               positions.size() * (sizeof(std::pair<const int, uint32_t>) + 2 * sizeof(void*));
+    }
+
+private:
+    std::vector<Entry> heap;
+    std::unordered_map<int, uint32_t> positions; // Question number -> index in heap
+
+    static bool before(const Entry& a, const Entry& b) {
+        return a.due < b.due || (a.due == b.due && a.number < b.number);
+    }
+
+    void place(size_t i, const Entry& entry) {
+        heap[i] = entry;
+        positions[entry.number] = static_cast<uint32_t>(i);
+    }
+
+    void siftUp(size_t i) {
+        Entry entry = heap[i];
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
+            if (!before(entry, heap[parent])) {
+                break;
+            }
+            place(i, heap[parent]);
+            i = parent;
+        }
+        place(i, entry);
+    }
+
+    void siftDown(size_t i) {
+        Entry entry = heap[i];
+        size_t count = heap.size();
+        while (true) {
+            size_t child = 2 * i + 1;
+            if (child >= count) {
+                break;
+            }
+            if (child + 1 < count && before(heap[child + 1], heap[child])) {
+                child++;
+            }
+            if (!before(heap[child], entry)) {
+                break;
+            }
+            place(i, heap[child]);
+            i = child;
+        }
+        place(i, entry);
+    }
+};
+
+#endif // REVIEW_QUEUE_H
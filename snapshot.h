@@ -0,0 +1,236 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "question.h"
+
+// Flat on-disk copy of the questions table, read back with mmap so startup
+// does not have to go through SQLite row by row.
+//
+// Layout, all integers in native byte order:
+//   SnapshotHeader
+//   uint64_t offsets[count + 1]   start of each text in the text block
+//   int64_t  dues[count]          next review, 0 when not in the review queue
+//   int32_t  numbers[count]       ascending
+//   int32_t  intervals[count]     days between the last two reviews
+//   uint8_t  statuses[count]
+//   char     text[textBytes]
+// The checksum covers everything after the header. The header also records
+// whose questions these are and the change log position the rows reflect, so
+// a reader can tell how stale the file is and replay only what came after.
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    int64_t user;
+    int64_t sequence;
+    uint64_t count;
+    uint64_t textBytes;
+    uint64_t checksum;
+};
+
+class QuestionSnapshot {
+public:
+    static constexpr uint32_t VERSION = 3;
+
+    QuestionSnapshot() = default;
+    QuestionSnapshot(const QuestionSnapshot&) = delete;
+    QuestionSnapshot& operator=(const QuestionSnapshot&) = delete;
+
+    ~QuestionSnapshot() {
+        close();
+    }
+
+    // Maps the file and checks its magic, version, size and checksum. Returns
+    // false for a missing, truncated, corrupt or foreign file.
+    bool open(const std::string& path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(SnapshotHeader)) {
+            ::close(fd);
+            return false;
+        }
+        void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // The mapping keeps the file contents reachable
+        if (mapped == MAP_FAILED) {
+            return false;
+        }
+        data = static_cast<const char*>(mapped);
+        bytes = static_cast<size_t>(info.st_size);
+        madvise(mapped, bytes, MADV_SEQUENTIAL);
+
+        const SnapshotHeader& header = *reinterpret_cast<const SnapshotHeader*>(data);
+        size_t count = static_cast<size_t>(header.count);
+        bool valid = memcmp(header.magic, MAGIC, sizeof(header.magic)) == 0 && header.version == VERSION &&
+                     header.count <= bytes && header.textBytes <= bytes &&
+                     bytes == layoutBytes(count, static_cast<size_t>(header.textBytes)) &&
+                     checksum(data + sizeof(SnapshotHeader), bytes - sizeof(SnapshotHeader)) == header.checksum;
+        if (valid) {
+            rows = count;
+            offsets = reinterpret_cast<const uint64_t*>(data + sizeof(SnapshotHeader));
+            dues = reinterpret_cast<const int64_t*>(offsets + count + 1);
+            numbers = reinterpret_cast<const int32_t*>(dues + count);
+            intervals = numbers + count;
+            statuses = reinterpret_cast<const uint8_t*>(intervals + count);
+            texts = reinterpret_cast<const char*>(statuses + count);
+            valid = offsets[count] == header.textBytes;
+        }
+        if (!valid) {
+            close();
+        }
+        return valid;
+    }
+
+    void close() {
+        if (data) {
+            munmap(const_cast<char*>(data), bytes);
+        }
+        data = nullptr;
+        bytes = 0;
+        rows = 0;
+    }
+
+    size_t size() const {
+        return rows;
+    }
+
+    // users.id of the questions' owner.
+    long long user() const {
+        return reinterpret_cast<const SnapshotHeader*>(data)->user;
+    }
+
+    long long sequence() const {
+        return reinterpret_cast<const SnapshotHeader*>(data)->sequence;
+    }
+
+    int number(size_t i) const {
+        return numbers[i];
+    }
+
+    long long due(size_t i) const {
+        return dues[i];
+    }
+
+    int interval(size_t i) const {
+        return intervals[i];
+    }
+
+    // Raw status byte; check it against STATUS_COUNT before casting.
+    uint8_t status(size_t i) const {
+        return statuses[i];
+    }
+
+    size_t textBytes() const {
+        return static_cast<size_t>(offsets[rows]);
+    }
+
+    std::string_view text(size_t i) const {
+        return std::string_view(texts + offsets[i], static_cast<size_t>(offsets[i + 1] - offsets[i]));
+    }
+
+    // Writes the questions, which must be in ascending number order, next to
+    // the path and renames the result into place, so readers never see a
+    // half-written file. Returns false if the file could not be written.
+    static bool write(const std::string& path, long long user, long long sequence,
+                      const std::vector<QuestionView>& questions) {
+        size_t count = questions.size();
+        size_t textBytes = 0;
+        for (const QuestionView& question : questions) {
+            textBytes += question.text.size();
+        }
+        std::vector<char> buffer(layoutBytes(count, textBytes));
+        SnapshotHeader header{};
+        memcpy(header.magic, MAGIC, sizeof(header.magic));
+        header.version = VERSION;
+        header.user = user;
+        header.sequence = sequence;
+        header.count = count;
+        header.textBytes = textBytes;
+
+        char* body = buffer.data() + sizeof(SnapshotHeader);
+        uint64_t* offsetColumn = reinterpret_cast<uint64_t*>(body);
+        int64_t* dueColumn = reinterpret_cast<int64_t*>(offsetColumn + count + 1);
+        int32_t* numberColumn = reinterpret_cast<int32_t*>(dueColumn + count);
+        int32_t* intervalColumn = numberColumn + count;
+        uint8_t* statusColumn = reinterpret_cast<uint8_t*>(intervalColumn + count);
+        char* textColumn = reinterpret_cast<char*>(statusColumn + count);
+        uint64_t offset = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const QuestionView& question = questions[i];
+            offsetColumn[i] = offset;
+            dueColumn[i] = question.due;
+            numberColumn[i] = question.number;
+            intervalColumn[i] = question.interval;
+            statusColumn[i] = static_cast<uint8_t>(question.status);
+            memcpy(textColumn + offset, question.text.data(), question.text.size());
+            offset += question.text.size();
+        }
+        offsetColumn[count] = offset;
+        header.checksum = checksum(body, buffer.size() - sizeof(SnapshotHeader));
+        memcpy(buffer.data(), &header, sizeof(header));
+
+        std::string temporary = path + ".tmp." + std::to_string(getpid());
+        FILE* file = fopen(temporary.c_str(), "wb");
+        if (!file) {
+            return false;
+        }
+        bool ok = fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+        ok = fclose(file) == 0 && ok;
+        if (!ok || rename(temporary.c_str(), path.c_str()) != 0) {
+            remove(temporary.c_str());
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static constexpr char MAGIC[8] = {'Q', 'S', 'N', 'A', 'P', 'S', 'H', 'T'};
+
+    const char* data = nullptr;
+    size_t bytes = 0;
+    size_t rows = 0;
+    const uint64_t* offsets = nullptr;
+    const int64_t* dues = nullptr;
+    const int32_t* numbers = nullptr;
+    const int32_t* intervals = nullptr;
+    const uint8_t* statuses = nullptr;
+    const char* texts = nullptr;
+
+    static size_t layoutBytes(size_t count, size_t textBytes) {
+        return sizeof(SnapshotHeader) + (count + 1) * sizeof(uint64_t) + count * sizeof(int64_t) +
+               2 * count * sizeof(int32_t) + count * sizeof(uint8_t) + textBytes;
+    }
+
+    // FNV-1a over 64-bit words, then over the trailing bytes. Enough to catch
+    // truncation and torn writes, and fast enough to check on every startup.
+    static uint64_t checksum(const char* bytes, size_t size) {
+        uint64_t hash = 14695981039346656037ull;
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+            uint64_t word;
+            memcpy(&word, bytes + i, sizeof(word));
+            hash = (hash ^ word) * 1099511628211ull;
+        }
+        for (; i < size; ++i) {
+            hash = (hash ^ static_cast<unsigned char>(bytes[i])) * 1099511628211ull;
+        }
+        return hash;
+    }
+};
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,229 @@
+#ifndef TAG_FILTER_H
+#define TAG_FILTER_H
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "bitmap.h"   // Include the compressed bitmaps queries combine
+#include "question.h" // Include parseStatusArgument
+
+// Tags are stored as typed but lowercased: letters, digits and "-_+#.", at
+// most 32 characters. A status name or one of the query keywords cannot be a
+// tag, so every word of a filter query means exactly one thing.
+inline bool parseTag(const std::string& text, std::string& tag) {
+    const size_t maxLength = 32;
+    if (text.empty() || text.size() > maxLength) {
+        return false;
+    }
+    std::string name;
+    for (char c : text) {
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+        bool allowed = (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '+' ||
+                       c == '#' || c == '.';
+        if (!allowed) {
+            return false;
+        }
+        name += c;
+    }
+    Status status;
+    if (name == "and" || name == "or" || name == "not" || parseStatusArgument(name, status)) {
+        return false;
+    }
+    tag = name;
+    return true;
+}
+
+// Splits a list such as "dp, Graph  two-pointers" on spaces and commas into
+// tags, sorted and without duplicates. On a word that is not a valid tag,
+// returns false with that word in invalid.
+inline bool parseTagList(const std::string& text, std::vector<std::string>& tags, std::string& invalid) {
+    tags.clear();
+    std::string word;
+    for (size_t i = 0; i <= text.size(); ++i) {
+        char c = i < text.size() ? text[i] : ' ';
+        if (c != ' ' && c != ',' && c != '\t') {
+            word += c;
+            continue;
+        }
+        if (word.empty()) {
+            continue;
+        }
+        std::string tag;
+        if (!parseTag(word, tag)) {
+            invalid = word;
+            return false;
+        }
+        tags.push_back(tag);
+        word.clear();
+    }
+    std::sort(tags.begin(), tags.end());
+    tags.erase(std::unique(tags.begin(), tags.end()), tags.end());
+    return true;
+}
+
+// Evaluates a filter query over bitmaps of question numbers. Words are status
+// names (as in parseStatusArgument, e.g. "submitted" or "under-review") or
+// tags; they combine with AND, OR and NOT (any case, or &, | and !) and
+// parentheses, AND binding tighter than OR. Words side by side are ANDed, so
+// "dp graph not submitted" == "dp AND graph AND NOT submitted". "x AND NOT y"
+// subtracts y from x directly rather than complementing y first. A blank
+// query matches every question.
+class FilterQuery {
+public:
+    // Bitmap a word stands for, or nullptr if it names no status or tag.
+    using Resolver = std::function<const Bitmap*(const std::string& word)>;
+
+    FilterQuery(const std::string& queryText, const Bitmap& everyQuestion, Resolver resolveWord)
+        : query(queryText), all(everyQuestion), resolve(std::move(resolveWord)) {}
+
+    // Returns false with a message in error if the query is malformed or
+    // names an unknown tag; result is then unspecified.
+    bool evaluate(Bitmap& result, std::string& error) {
+        next();
+        if (token.empty()) {
+            result = all;
+            return true;
+        }
+        if (!expression(result)) {
+            error = message;
+            return false;
+        }
+        if (!token.empty()) {
+            error = "unexpected '" + token + "'";
+            return false;
+        }
+        return true;
+    }
+
+private:
+    // One operand of an AND: a bitmap of the resolver's, which is used in
+    // place, or one computed for a parenthesised expression.
+    struct Operand {
+        const Bitmap* shared = nullptr;
+        Bitmap owned;
+        bool negated = false;
+
+        const Bitmap& bits() const {
+            return shared ? *shared : owned;
+        }
+    };
+
+    const std::string& query;
+    const Bitmap& all;
+    Resolver resolve;
+    size_t position = 0;
+    std::string token; // Current token, lowercased; empty at the end
+    std::string message;
+
+    static bool isOperator(char c) {
+        return c == '(' || c == ')' || c == '&' || c == '|' || c == '!';
+    }
+
+    void next() {
+        while (position < query.size() && (query[position] == ' ' || query[position] == '\t')) {
+            position++;
+        }
+        token.clear();
+        if (position < query.size() && isOperator(query[position])) {
+            token = query[position++];
+            return;
+        }
+        while (position < query.size() && query[position] != ' ' && query[position] != '\t' &&
+               !isOperator(query[position])) {
+            char c = query[position++];
+            token += (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+        }
+    }
+
+    bool fail(const std::string& text) {
+        if (message.empty()) {
+            message = text;
+        }
+        return false;
+    }
+
+    // expression := term (OR term)*
+    bool expression(Bitmap& result) {
+        if (!term(result)) {
+            return false;
+        }
+        while (token == "or" || token == "|") {
+            next();
+            Bitmap other;
+            if (!term(other)) {
+                return false;
+            }
+            result.uniteWith(other);
+        }
+        return true;
+    }
+
+    // term := factor ((AND)? factor)*
+    bool term(Bitmap& result) {
+        Operand first;
+        if (!factor(first)) {
+            return false;
+        }
+        if (first.negated) {
+            result = all;
+            result.subtract(first.bits());
+        } else if (first.shared) {
+            result = *first.shared;
+        } else {
+            result = std::move(first.owned);
+        }
+        while (!token.empty() && token != "or" && token != "|" && token != ")") {
+            if (token == "and" || token == "&") {
+                next();
+            }
+            Operand operand;
+            if (!factor(operand)) {
+                return false;
+            }
+            if (operand.negated) {
+                result.subtract(operand.bits());
+            } else {
+                result.intersectWith(operand.bits());
+            }
+        }
+        return true;
+    }
+
+    // factor := NOT factor | '(' expression ')' | word
+    bool factor(Operand& operand) {
+        if (token == "not" || token == "!") {
+            next();
+            if (!factor(operand)) {
+                return false;
+            }
+            operand.negated = !operand.negated;
+            return true;
+        }
+        if (token == "(") {
+            next();
+            if (!expression(operand.owned)) {
+                return false;
+            }
+            if (token != ")") {
+                return fail("missing ')'");
+            }
+            next();
+            return true;
+        }
+        if (token.empty() || token == ")" || token == "and" || token == "&" || token == "or" || token == "|") {
+            return fail(token.empty() ? "expected a tag or status at the end" : "expected a tag or status before '" + token + "'");
+        }
+        operand.shared = resolve(token);
+        if (!operand.shared) {
+            return fail("no tag or status '" + token + "'");
+        }
+        next();
+        return true;
+    }
+};
+
+#endif // TAG_FILTER_H
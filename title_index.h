@@ -0,0 +1,423 @@
+#ifndef TITLE_INDEX_H
+#define TITLE_INDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct TitleMatch {
+    int number;   // Question number
+    int distance; // Typos corrected to match every query word
+};
+
+// In-memory index for typo-tolerant title search ("lru cach", "two sum ii").
+// Titles are folded to lower-case words. Every distinct word is listed once in
+// a vocabulary with the titles that use it, and the vocabulary words are split
+// into overlapping three-byte grams (a leading space marks the word start)
+// with a posting list per gram.
+//
+// Each query word must match the start of some title word, with one typo
+// allowed from five characters on and two from nine. A word within k typos
+// keeps all but at most 3k of its grams, so only vocabulary words sharing
+// enough grams are checked by edit distance, and each of those only once no
+// matter how many titles use it. The titles are then the intersection of the
+// matched words' title lists. Removed titles are only marked dead and swept
+// out in bulk once they outnumber the live ones, so every update stays
+// O(title length).
+class TitleIndex {
+public:
+    void clear() {
+        titles.clear();
+        titleWords.clear();
+        ids.clear();
+        vocabulary.clear();
+        wordIds.clear();
+        postings.clear();
+        dead = 0;
+    }
+
+    size_t size() const {
+        return ids.size();
+    }
+
+    void insert(int number, std::string_view title) {
+        erase(number);
+        std::vector<uint32_t> words;
+        std::string folded = fold(title);
+        for (size_t start = 1; start < folded.size();) { // folded starts with a space
+            size_t end = std::min(folded.find(' ', start), folded.size());
+            words.push_back(wordId(folded.substr(start, end - start)));
+            start = end + 1;
+        }
+        add(number, static_cast<uint32_t>(folded.size()), std::move(words));
+    }
+
+    void erase(int number) {
+        auto it = ids.find(number);
+        if (it == ids.end()) {
+            return;
+        }
+        titles[it->second].live = false;
+        ids.erase(it);
+        dead++;
+        if (dead > 1024 && dead > ids.size()) {
+            compact();
+        }
+    }
+
+    // Titles matching every word of the query, fewest typos first, then
+    // shortest, at most limit of them.
+    std::vector<TitleMatch> search(const std::string& query, size_t limit) const {
+        std::vector<QueryWord> words;
+        std::string folded = fold(query);
+        for (size_t start = 1; start < folded.size();) {
+            size_t end = std::min(folded.find(' ', start), folded.size());
+            words.emplace_back(folded.substr(start, end - start));
+            expand(words.back(), std::string_view(folded).substr(start - 1, end - start + 1));
+            if (words.back().matches.empty()) {
+                return {};
+            }
+            start = end + 1;
+        }
+        if (words.empty() || limit == 0) {
+            return {};
+        }
+
+        // Intersect the title lists, most selective word first
+        std::sort(words.begin(), words.end(), [](const QueryWord& a, const QueryWord& b) { return a.cost < b.cost; });
+        reserveScratch(titles.size());
+        distance.resize(std::max(distance.size(), titles.size()));
+        std::vector<uint32_t> candidates;
+        nextGeneration();
+        for (const auto& [word, typos] : words[0].matches) {
+            for (uint32_t id : vocabulary[word].titles) {
+                if (seen[id] != generation) {
+                    seen[id] = generation;
+                    distance[id] = static_cast<uint8_t>(typos);
+                    candidates.push_back(id);
+                } else {
+                    distance[id] = std::min<uint8_t>(distance[id], typos);
+                }
+            }
+        }
+        for (size_t w = 1; w < words.size() && !candidates.empty(); ++w) {
+            for (uint32_t id : candidates) {
+                best[id] = NO_MATCH;
+            }
+            for (const auto& [word, typos] : words[w].matches) {
+                const std::vector<uint32_t>& list = vocabulary[word].titles;
+                if (candidates.size() * 16 < list.size()) { // Few candidates: probe instead of walking
+                    for (uint32_t id : candidates) {
+                        if (std::binary_search(list.begin(), list.end(), id)) {
+                            best[id] = std::min<uint8_t>(best[id], typos);
+                        }
+                    }
+                } else {
+                    for (uint32_t id : list) {
+                        if (seen[id] == generation) {
+                            best[id] = std::min<uint8_t>(best[id], typos);
+                        }
+                    }
+                }
+            }
+            nextGeneration();
+            size_t kept = 0;
+            for (uint32_t id : candidates) {
+                if (best[id] != NO_MATCH) {
+                    seen[id] = generation;
+                    distance[id] += best[id];
+                    candidates[kept++] = id;
+                }
+            }
+            candidates.resize(kept);
+        }
+
+        // Rank by one packed key: typos, then folded length (shorter titles
+        // match more of their text), then question number
+        std::vector<uint64_t> keys;
+        keys.reserve(candidates.size());
+        for (uint32_t id : candidates) {
+            const Title& title = titles[id];
+            if (title.live) {
+                keys.push_back(uint64_t(distance[id]) << 48 | uint64_t(title.length) << 32 |
+                               static_cast<uint32_t>(title.number));
+            }
+        }
+        size_t kept = std::min(limit, keys.size());
+        std::partial_sort(keys.begin(), keys.begin() + kept, keys.end());
+        std::vector<TitleMatch> ranked;
+        ranked.reserve(kept);
+        for (size_t i = 0; i < kept; ++i) {
+            ranked.push_back({static_cast<int>(static_cast<uint32_t>(keys[i])), static_cast<int>(keys[i] >> 48)});
+        }
+        return ranked;
+    }
+
+    // Approximate heap bytes held by the index, including hash table buckets
+    // and nodes.
+    size_t memoryBytes() const {
+        size_t bytes = titles.capacity() * sizeof(Title) + titleWords.capacity() * sizeof(uint32_t) +
+                       vocabulary.capacity() * sizeof(Word) + seen.capacity() * sizeof(uint32_t) + best.capacity() +
+                       distance.capacity();
+        for (const Word& word : vocabulary) {
+            bytes += word.titles.capacity() * sizeof(uint32_t);
+            if (word.text.capacity() > sizeof(std::string) - 1) { // Short strings live inside the object
+                bytes += word.text.capacity() + 1;
+            }
+        }
+        bytes += ids.bucket_count() * sizeof(void*) + ids.size() * (sizeof(void*) + sizeof(std::pair<int, uint32_t>));
+        bytes += wordIds.bucket_count() * sizeof(void*) +
+                 wordIds.size() * (2 * sizeof(void*) + sizeof(std::pair<std::string, uint32_t>));
+        bytes += postings.bucket_count() * sizeof(void*);
+        for (const auto& entry : postings) {
+            bytes += sizeof(void*) + sizeof(entry) + entry.second.capacity() * sizeof(uint32_t);
+        }
+        return bytes;
+    }
+
+private:
+    static constexpr uint8_t NO_MATCH = 255;
+
+    struct Title {
+        int number;
+        uint32_t firstWord; // Its distinct words are titleWords[firstWord, firstWord + wordCount)
+        uint16_t wordCount;
+        uint16_t length;    // Folded length, the ranking tie-breaker
+        bool live;
+    };
+
+    struct Word {
+        std::string text;
+        std::vector<uint32_t> titles; // Ids of the titles using it, ascending, dead ones too
+    };
+
+    // A query word prepared for Myers' bit-parallel matcher (bit i of mask[c]
+    // is set where the word has byte c at position i), with the vocabulary
+    // words it matches.
+    struct QueryWord {
+        std::string text;
+        int typos; // Edits allowed
+        uint64_t mask[256] = {};
+        std::vector<std::pair<uint32_t, uint8_t>> matches; // Vocabulary word and typos
+        size_t cost = 0;                                   // Title ids listed under the matches
+
+        explicit QueryWord(std::string word)
+            : text(std::move(word)), typos(text.size() < 5 ? 0 : text.size() < 9 ? 1 : 2) {
+            for (size_t i = 0; i < text.size() && i < 64; ++i) {
+                mask[static_cast<unsigned char>(text[i])] |= uint64_t(1) << i;
+            }
+        }
+    };
+
+    std::vector<Title> titles;                                   // Indexed by id, in insertion order
+    std::vector<uint32_t> titleWords;                            // Word ids of every title back to back
+    std::unordered_map<int, uint32_t> ids;                       // Question number -> id of its live title
+    std::vector<Word> vocabulary;                                // Indexed by word id
+    std::unordered_map<std::string, uint32_t> wordIds;           // Word -> word id
+    std::unordered_map<uint32_t, std::vector<uint32_t>> postings; // Gram -> word ids in ascending order
+    size_t dead = 0;                                             // Titles erased but still listed
+    mutable std::vector<uint32_t> seen;                          // Per-search stamps, by title or word id
+    mutable std::vector<uint8_t> best;                           // Fewest typos for the current query word
+    mutable std::vector<uint8_t> distance;                       // Typos summed over the query words so far
+    mutable uint32_t generation = 0;
+    const std::vector<uint32_t> empty;
+
+    // Finds the vocabulary words within the query word's typos. word is the
+    // query word with its leading space, for the grams. A word within k typos
+    // shares at least `required` grams with it, so it appears in one of the
+    // (total - required + 1) rarest gram lists; only those are candidates.
+    void expand(QueryWord& query, std::string_view word) const {
+        std::vector<const std::vector<uint32_t>*> lists;
+        for (uint32_t gram : grams(word)) {
+            auto it = postings.find(gram);
+            lists.push_back(it == postings.end() ? &empty : &it->second);
+        }
+        std::sort(lists.begin(), lists.end(),
+                  [](const std::vector<uint32_t>* a, const std::vector<uint32_t>* b) { return a->size() < b->size(); });
+        int required = static_cast<int>(lists.size()) - 3 * query.typos;
+
+        std::vector<uint32_t> candidates;
+        if (required < 1) { // Too short for its typos to leave a gram intact: try every word
+            for (uint32_t id = 0; id < vocabulary.size(); ++id) {
+                candidates.push_back(id);
+            }
+        } else {
+            reserveScratch(vocabulary.size());
+            nextGeneration();
+            for (size_t i = 0; i < lists.size(); ++i) {
+                for (uint32_t id : *lists[i]) {
+                    if (seen[id] == generation) {
+                        best[id]++;
+                    } else if (i + required <= lists.size()) {
+                        seen[id] = generation;
+                        best[id] = 1;
+                        candidates.push_back(id);
+                    }
+                }
+            }
+            candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                            [&](uint32_t id) { return best[id] < required; }),
+                             candidates.end());
+        }
+        for (uint32_t id : candidates) {
+            int typos = prefixDistance(query, vocabulary[id].text);
+            if (typos <= query.typos) {
+                query.matches.push_back({id, static_cast<uint8_t>(typos)});
+                query.cost += vocabulary[id].titles.size();
+            }
+        }
+    }
+
+    // Grows the stamp and count arrays, shared by the word and title passes.
+    void reserveScratch(size_t ids) const {
+        if (seen.size() < ids) {
+            seen.resize(ids, 0);
+            best.resize(ids, 0);
+        }
+    }
+
+    void nextGeneration() const {
+        if (++generation == 0) { // Stamps wrapped: forget every old mark
+            std::fill(seen.begin(), seen.end(), 0);
+            generation = 1;
+        }
+    }
+
+    // Edit distance between the query word and the closest prefix of
+    // candidate. Words up to 64 bytes run Myers' algorithm, one column of the
+    // DP table per machine word; longer ones fill the table a column at a time.
+    static int prefixDistance(const QueryWord& query, const std::string& candidate) {
+        size_t n = query.text.size();
+        int score = static_cast<int>(n); // Last row of the current column
+        int closest = score;
+        if (n <= 64) {
+            uint64_t high = uint64_t(1) << (n - 1);
+            uint64_t positive = ~uint64_t(0), negative = 0; // Vertical deltas down the column
+            for (unsigned char c : candidate) {
+                uint64_t equal = query.mask[c];
+                uint64_t xv = equal | negative;
+                uint64_t xh = (((equal & positive) + positive) ^ positive) | equal;
+                uint64_t up = negative | ~(xh | positive); // Horizontal deltas
+                uint64_t down = positive & xh;
+                if (up & high) {
+                    score++;
+                } else if (down & high) {
+                    score--;
+                }
+                up = (up << 1) | 1; // Row 0 grows by one per column: the match is anchored
+                down <<= 1;
+                positive = down | ~(xv | up);
+                negative = up & xv;
+                closest = std::min(closest, score);
+            }
+            return closest;
+        }
+        std::vector<int> column(n + 1);
+        for (size_t i = 0; i <= n; ++i) {
+            column[i] = static_cast<int>(i);
+        }
+        for (char c : candidate) {
+            int diagonal = column[0]++;
+            for (size_t i = 1; i <= n; ++i) {
+                int above = column[i];
+                column[i] = std::min({diagonal + (query.text[i - 1] == c ? 0 : 1), above + 1, column[i - 1] + 1});
+                diagonal = above;
+            }
+            closest = std::min(closest, column[n]);
+        }
+        return closest;
+    }
+
+    // The vocabulary id of a word, adding it and its grams if it is new.
+    uint32_t wordId(const std::string& text) {
+        auto it = wordIds.find(text);
+        if (it != wordIds.end()) {
+            return it->second;
+        }
+        uint32_t id = static_cast<uint32_t>(vocabulary.size());
+        vocabulary.push_back({text, {}});
+        wordIds.emplace(text, id);
+        for (uint32_t gram : grams(" " + text)) {
+            std::vector<uint32_t>& list = postings[gram];
+            if (list.empty() || list.back() != id) { // grams() is sorted, but a gram can repeat
+                list.push_back(id);
+            }
+        }
+        return id;
+    }
+
+    void add(int number, uint32_t length, std::vector<uint32_t> words) {
+        std::sort(words.begin(), words.end());
+        words.erase(std::unique(words.begin(), words.end()), words.end());
+        uint32_t id = static_cast<uint32_t>(titles.size());
+        titles.push_back({number, static_cast<uint32_t>(titleWords.size()), static_cast<uint16_t>(words.size()),
+                          static_cast<uint16_t>(std::min<uint32_t>(length, UINT16_MAX)), true});
+        ids[number] = id;
+        for (uint32_t word : words) {
+            titleWords.push_back(word);
+            vocabulary[word].titles.push_back(id);
+        }
+    }
+
+    // Renumbers the live titles and rebuilds the vocabulary without the words
+    // and list entries only dead titles used.
+    void compact() {
+        std::vector<Title> oldTitles = std::move(titles);
+        std::vector<uint32_t> oldTitleWords = std::move(titleWords);
+        std::vector<Word> oldVocabulary = std::move(vocabulary);
+        clear();
+        for (const Title& title : oldTitles) {
+            if (!title.live) {
+                continue;
+            }
+            std::vector<uint32_t> words;
+            for (uint32_t i = 0; i < title.wordCount; ++i) {
+                words.push_back(wordId(oldVocabulary[oldTitleWords[title.firstWord + i]].text));
+            }
+            add(title.number, title.length, std::move(words));
+        }
+        seen.clear();
+        seen.shrink_to_fit();
+        best.clear();
+        best.shrink_to_fit();
+        distance.clear();
+        distance.shrink_to_fit();
+    }
+
+    // Lower-case ASCII letters and digits, with every run of anything else
+    // turned into one space and a leading space before the first word. Bytes
+    // of UTF-8 sequences are kept as they are.
+    static std::string fold(std::string_view text) {
+        std::string folded = " ";
+        for (unsigned char c : text) {
+            if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c >= 0x80) {
+                folded += static_cast<char>(c);
+            } else if (c >= 'A' && c <= 'Z') {
+                folded += static_cast<char>(c - 'A' + 'a');
+            } else if (folded.back() != ' ') {
+                folded += ' ';
+            }
+        }
+        if (folded.back() == ' ') {
+            folded.pop_back();
+        }
+        return folded;
+    }
+
+    // Sorted grams of a string; empty if it is shorter than three bytes.
+    static std::vector<uint32_t> grams(std::string_view text) {
+        std::vector<uint32_t> result;
+        for (size_t i = 0; i + 3 <= text.size(); ++i) {
+            result.push_back(static_cast<uint32_t>(static_cast<unsigned char>(text[i])) << 16 |
+                             static_cast<uint32_t>(static_cast<unsigned char>(text[i + 1])) << 8 |
+                             static_cast<unsigned char>(text[i + 2]));
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+};
+
+#endif // TITLE_INDEX_H
@@ -2,9 +2,18 @@
 #include <vector>
 #include <string>
 #include "database.cpp" // Include the database header
+#include "question_cache.h" // Include the write-through question cache
+#include "list_view.h" // Include the paginated question list
+#include "incremental_search.h" // Include search-as-you-type result reuse
+#include "cli.h" // Include the headless command-line mode
+#include "render.h" // Include the damage-tracked windows
+#include "event_loop.h" // Include the central event loop
 #include <cstring> // Include for strlen
-#include <cctype>  // Include for isdigit
 #include <algorithm> // Include for remove_if
+#include <chrono> // Include for search timing
+#include <ctime> // Include for progress dates
+#include <poll.h> // Include for poll
+#include <unistd.h> // Include for STDIN_FILENO
 
 using namespace std;
 
@@ -15,104 +24,389 @@ public:
     void run() {
         // Handle user authentication
         if (!handleAuthentication()) {
-            endwin();
+            screen.close();
             return;
         }
 
-        questions = db.getQuestions(); // Load questions from the database on startup
-        initscr(); // Initialize ncurses
-        cbreak(); // Disable line buffering
-        noecho(); // Don't echo input
-        keypad(stdscr, TRUE); // Enable special keys
-        mousemask(ALL_MOUSE_EVENTS, NULL); // Enable mouse events
+        worker.setNotify([this] { events.wake(); }); // Finished writes wake the loop
+        events.onWakeup([this] { questions.poll(); }); // Apply background write confirmations
+        worker.setUser(db.user()); // Writes go to the signed-in user's questions; the first job, so after setNotify
+        events.every(refreshIntervalMs, [this] {
+            questions.refreshIfChanged(); // Pick up commits from other connections while idle
+        });
+        questions.attachWorker(&worker); // Write in the background from here on
+        if (!snapshotPath.empty()) {
+            questions.loadSnapshot(snapshotPath); // Rows as of the last clean exit, if still usable
+        }
+        questions.refreshIfChanged(); // Load questions from the database, or catch the snapshot up
 
         int choice = 0;
-        vector<string> options = {"Add Question", "Show Questions", "Search Question", "Delete All Questions", "Exit"};
-        while (true) {
-            clear();
-            printMenu(options, choice);
-            int ch = getch();
-            if (ch == KEY_UP) {
-                choice = (choice - 1 + options.size()) % options.size();
-            } else if (ch == KEY_DOWN) {
-                choice = (choice + 1) % options.size();
-            } else if (ch == 10) { // Enter key
-                if (choice == 0) {
-                    addQuestion();
-                } else if (choice == 1) {
-                    showQuestions();
-                } else if (choice == 2) {
-                    searchQuestion();
-                } else if (choice == 3) {
-                    deleteAllQuestions();
-                } else if (choice == 4) {
-                    clear(); // Clear the screen before exiting
-                    printSubmittedCount(); // Print count of submitted questions
-                    getch(); // Wait for user input before exiting
-                    break; // Exit
+        vector<string> options = {"Add Question", "Show Questions", "Search Question", "Search Text", "Filter by Tags", "Progress", "Review", "Delete All Questions", "Exit"};
+        events.run([&] {
+            TRACK_LATENCY("TUI::render(menu)");
+            screen.body().setLine(0, "");
+            screen.drawOptions(1, options, choice, 1);
+            screen.body().clearFrom(options.size() + 1);
+            screen.status().setLine(0, "Up/Down to move, Enter to select", A_REVERSE);
+        }, [&](const Event& event) {
+            if (event.type == Event::Wakeup) {
+                size_t failed = questions.takeFailedWrites();
+                if (failed > 0) {
+                    showPopup(to_string(failed) + " change(s) could not be saved and were reverted.");
+                    questions.refreshIfChanged(); // Reconcile with what the database holds
                 }
-            } else if (ch == KEY_MOUSE) {
-                MEVENT event;
-                if (getmouse(&event) == OK) {
-                    if (event.x >= 0 && event.x < COLS && event.y >= 0 && event.y < LINES) {
-                        // Check if mouse click is on the menu options
-                        if (event.y == 1) { // Assuming the first option is on the second line
-                            addQuestion();
-                        } else if (event.y == 2) { // Assuming the second option is on the third line
-                            showQuestions();
-                        } else if (event.y == 3) { // Assuming the third option is on the fourth line
-                            searchQuestion();
-                        } else if (event.y == 4) { // Assuming the fourth option is on the fifth line
-                            clear(); // Clear the screen before exiting
-                            printSubmittedCount(); // Print count of submitted questions
-                            getch(); // Wait for user input before exiting
-                            break; // Exit
-                        }
-                    }
+            } else if (event.type == Event::Mouse) {
+                // Menu options are drawn from the second line down
+                if (event.mouse.y >= 1 && event.mouse.y <= static_cast<int>(options.size())) {
+                    choice = event.mouse.y - 1;
+                    return runMenuOption(choice); // False on Exit
+                }
+            } else if (event.type == Event::Key) {
+                if (event.key == KEY_UP) {
+                    choice = (choice - 1 + options.size()) % options.size();
+                } else if (event.key == KEY_DOWN) {
+                    choice = (choice + 1) % options.size();
+                } else if (event.key == 10) { // Enter key
+                    return runMenuOption(choice); // False on Exit
+                } else if (event.key == 's') { // Hidden: performance stats
+                    showStats();
                 }
             }
+            return true;
+        });
+
+        screen.close(); // End ncurses mode
+        if (!snapshotPath.empty()) {
+            questions.refreshIfChanged(); // Record the change log position our own writes reached
+            questions.saveSnapshot(snapshotPath); // Best effort; the next start falls back to the table
         }
+    }
 
-        endwin(); // End ncurses mode
+    // Latency histograms, cache counters and terminal output, for --stats-dump.
+    vector<string> statsReport() {
+        vector<string> lines = db.statsReport();
+        if (optional<unsigned long long> bytes = screen.bytesWritten()) {
+            lines.push_back("Terminal output: " + to_string(*bytes) + " bytes");
+        }
+        if (size_t count = questions.size()) {
+            char line[96];
+            snprintf(line, sizeof(line), "Question rows: %zu bytes, %.1f per question", questions.rowBytes(),
+                     static_cast<double>(questions.rowBytes()) / count);
+            lines.push_back(line);
+        }
+        if (size_t bytes = questions.titleIndexBytes()) {
+            lines.push_back("Title index: " + to_string(bytes) + " bytes");
+        }
+        return lines;
     }
 
 private:
-    Database db{"questions.db"}; // Initialize the database
-    vector<Question> questions; // Store questions with their statuses
+    Database db{"questions.db", screenOptions(DatabaseOptions())}; // Initialize the database
+    DatabaseWorker worker{"questions.db", writerOptions()}; // Background writer with its own connection
+    QuestionCache questions{db}; // Write-through cache of questions with their statuses
+    Screen screen; // Persistent windows; only changed rows reach the terminal
+    EventLoop events{screen}; // Keys, timers and background completions
     string currentUsername; // Store the logged-in username
+    string snapshotPath = snapshotPathSetting(); // Startup snapshot file, empty when disabled
+
+    static constexpr int refreshIntervalMs = 1000; // How often to look for commits from other connections
+
+    // TRACKER_SNAPSHOT names the startup snapshot file; set it empty to turn
+    // snapshots off.
+    static string snapshotPathSetting() {
+        const char* value = getenv("TRACKER_SNAPSHOT");
+        return value ? value : "questions.db.snapshot";
+    }
+
+    // SQL errors are reported on screen; text on stderr would be drawn over it.
+    static DatabaseOptions screenOptions(DatabaseOptions options) {
+        options.logErrors = false;
+        return withEnvironmentOverrides(options);
+    }
+
+    // The background writer batches bursts of changes into one commit.
+    static DatabaseOptions writerOptions() {
+        DatabaseOptions options;
+        options.groupCommitOps = 64;
+        options.groupCommitWindowMs = 50;
+        return screenOptions(options);
+    }
+
+    // Runs the main menu entry at the given index. Returns false on Exit.
+    bool runMenuOption(int choice) {
+        if (choice == 0) {
+            addQuestion();
+        } else if (choice == 1) {
+            showQuestions();
+        } else if (choice == 2) {
+            searchQuestion();
+        } else if (choice == 3) {
+            searchText();
+        } else if (choice == 4) {
+            filterQuestions();
+        } else if (choice == 5) {
+            showProgress();
+        } else if (choice == 6) {
+            showReview();
+        } else if (choice == 7) {
+            deleteAllQuestions();
+        } else if (choice == 8) {
+            worker.drain(); // Make sure every change has reached the database
+            questions.poll();
+            screen.body().clearFrom(0);
+            printSubmittedCount(); // Print count of submitted questions
+            screen.status().setLine(0, "Press any key to exit", A_REVERSE);
+            events.waitForKey(); // Wait for user input before exiting
+            return false;
+        }
+        return true;
+    }
+
+    // Live view of the latency histograms and cache counters, refreshed twice a
+    // second until ESC or 'q'. Not listed in the menu; opened with 's'.
+    void showStats() {
+        int ticker = events.every(500, nullptr); // Redraws on every tick
+        events.run([&] {
+            TRACK_LATENCY("TUI::render(stats)");
+            screen.body().setLine(0, "Stats", A_BOLD);
+            vector<string> lines = statsReport();
+            for (size_t i = 0; i < lines.size(); ++i) {
+                screen.body().setLine(i + 1, lines[i]);
+            }
+            screen.body().clearFrom(lines.size() + 1);
+            screen.status().setLine(0, "ESC to return", A_REVERSE);
+        }, [&](const Event& event) {
+            return !(event.type == Event::Key && (event.key == 27 || event.key == 'q'));
+        });
+        events.cancel(ticker);
+    }
+
+    // Status moves per week over the last 12 weeks, plus today and all time,
+    // read from the summary tables once a second while open.
+    void showProgress() {
+        const int weeks = 12;
+        ProgressSummary summary;
+        bool ok = db.progressSummary(weeks * 7, summary);
+        int ticker = events.every(1000, [&] { ok = db.progressSummary(weeks * 7, summary); });
+        events.run([&] {
+            TRACK_LATENCY("TUI::render(progress)");
+            Pane& body = screen.body();
+            int row = 0;
+            body.setLine(row++, "Progress", A_BOLD);
+            string now = "Now:";
+            for (size_t i = 0; i < STATUS_COUNT; ++i) {
+                now += string(i ? ", " : " ") + to_string(questions.count(static_cast<Status>(i))) + " " +
+                       statusName(static_cast<Status>(i));
+            }
+            body.setLine(row++, now);
+            body.setLine(row++, "");
+            if (!ok) {
+                body.setLine(row++, "Cannot read progress: " + db.lastErrorMessage());
+            } else if (summary.firstDay < 0) {
+                body.setLine(row++, "No status changes recorded yet.");
+            } else {
+                body.setLine(row++, progressRow("Moved into", "Submitted", "Under Review", "Not Understood"), A_UNDERLINE);
+                StatusMoves today;
+                if (!summary.days.empty() && summary.days.back().day == summary.today) {
+                    today = summary.days.back();
+                }
+                body.setLine(row++, progressRow("Today", today));
+                // Weeks start on Monday; day 0 was a Thursday
+                long long thisWeek = summary.today - (summary.today + 3) % 7;
+                for (int week = 0; week < weeks; ++week) {
+                    long long start = thisWeek - 7 * week;
+                    StatusMoves moves;
+                    for (const StatusMoves& day : summary.days) {
+                        if (day.day >= start && day.day < start + 7) {
+                            for (size_t i = 0; i < STATUS_COUNT; ++i) {
+                                moves.entered[i] += day.entered[i];
+                            }
+                        }
+                    }
+                    body.setLine(row++, progressRow(week == 0 ? "This week" : "Week of " + formatDay(start), moves));
+                }
+                body.setLine(row++, progressRow("Since " + formatDay(summary.firstDay), summary.total));
+            }
+            body.clearFrom(row);
+            screen.status().setLine(0, "ESC to return", A_REVERSE);
+        }, [&](const Event& event) {
+            return !(event.type == Event::Key && (event.key == 27 || event.key == 'q'));
+        });
+        events.cancel(ticker);
+    }
+
+    // Spaced repetition over the questions Under Review or Not Understood: shows
+    // the earliest-due one, records how the review went and reschedules it.
+    // Redraws every second so cards that fall due appear on their own.
+    void showReview() {
+        const size_t upcoming = 10;
+        int ticker = events.every(1000, nullptr);
+        events.run([&] {
+            TRACK_LATENCY("TUI::render(review)");
+            long long now = time(nullptr);
+            vector<QuestionView> due = questions.nextDue(upcoming + 1);
+            Pane& body = screen.body();
+            int row = 0;
+            body.setLine(row++, "Review", A_BOLD);
+            body.setLine(row++, to_string(questions.dueCount(now)) + " due now, " + to_string(questions.queued()) +
+                                " in the review queue");
+            body.setLine(row++, "");
+            if (due.empty()) {
+                body.setLine(row++, "The review queue is empty. Questions marked Under Review or Not Understood join it.");
+            } else if (due.front().due > now) {
+                body.setLine(row++, "Nothing is due. Next review " + formatTime(due.front().due) + ".");
+            } else {
+                const QuestionView& card = due.front();
+                body.setLine(row++, to_string(card.number) + ": " + string(card.text), A_BOLD);
+                body.setLine(row++, string("Status: ") + statusName(card.status) + " | Interval: " +
+                                    to_string(card.interval) + " day(s) | Due since " + formatTime(card.due));
+                int good = scheduleAfter(ReviewOutcome::Good, card.interval, now).interval;
+                int easy = scheduleAfter(ReviewOutcome::Easy, card.interval, now).interval;
+                body.setLine(row++, "1 Again (tomorrow)  2 Good (" + to_string(good) + " days)  3 Easy (" +
+                                    to_string(easy) + " days)  d Done (mark Submitted)");
+                due.erase(due.begin());
+            }
+            if (!due.empty()) {
+                body.setLine(row++, "");
+                body.setLine(row++, "Coming up", A_UNDERLINE);
+                for (const QuestionView& question : due) {
+                    body.setLine(row++, formatTime(question.due) + "  " + to_string(question.number) + ": " +
+                                        string(question.text));
+                }
+            }
+            body.clearFrom(row);
+            screen.status().setLine(0, "1/2/3/d to record the review, ESC to return", A_REVERSE);
+        }, [&](const Event& event) {
+            if (event.type != Event::Key) {
+                return true;
+            }
+            if (event.key == 27 || event.key == 'q') {
+                return false;
+            }
+            ReviewOutcome outcome;
+            if (event.key == '1') {
+                outcome = ReviewOutcome::Again;
+            } else if (event.key == '2') {
+                outcome = ReviewOutcome::Good;
+            } else if (event.key == '3') {
+                outcome = ReviewOutcome::Easy;
+            } else if (event.key == 'd') {
+                outcome = ReviewOutcome::Done;
+            } else {
+                return true;
+            }
+            long long now = time(nullptr);
+            vector<QuestionView> due = questions.nextDue(1);
+            if (!due.empty() && due.front().due <= now && !questions.recordReview(due.front().number, outcome, now)) {
+                showPopup("Failed to record the review.");
+            }
+            return true;
+        });
+        events.cancel(ticker);
+    }
+
+    // YYYY-MM-DD HH:MM in local time.
+    static string formatTime(long long unixTime) {
+        time_t time = static_cast<time_t>(unixTime);
+        struct tm date;
+        localtime_r(&time, &date);
+        char text[32];
+        strftime(text, sizeof(text), "%Y-%m-%d %H:%M", &date);
+        return text;
+    }
+
+    static string progressRow(const string& label, const StatusMoves& moves) {
+        return progressRow(label, to_string(moves.entered[0]), to_string(moves.entered[1]), to_string(moves.entered[2]));
+    }
+
+    static string progressRow(const string& label, const string& first, const string& second, const string& third) {
+        char line[128];
+        snprintf(line, sizeof(line), "%-20s %14s %14s %14s", label.c_str(), first.c_str(), second.c_str(), third.c_str());
+        return line;
+    }
+
+    // YYYY-MM-DD for a day number from the status summaries.
+    static string formatDay(long long day) {
+        time_t time = static_cast<time_t>(day * 86400);
+        struct tm date;
+        gmtime_r(&time, &date); // The day number is already local
+        char text[16];
+        strftime(text, sizeof(text), "%Y-%m-%d", &date);
+        return text;
+    }
 
     void printSubmittedCount() {
-        int count = 0;
-        for (const auto& question : questions) {
-            if (question.status == "Submitted") {
-                count++;
+        screen.body().setLine(1, "Total Submitted Questions: " + to_string(questions.count(Status::Submitted)), A_NORMAL, 1);
+    }
+
+    // Highlighted choice among options listed below a heading. Returns the index
+    // picked with Enter or a mouse click, or -1 if cancelOption was picked.
+    int chooseOption(const string& heading, const vector<string>& options, int cancelOption) {
+        int selected = 0;
+        events.run([&] {
+            screen.body().setLine(0, heading);
+            screen.drawOptions(1, options, selected, 0, true);
+            screen.body().clearFrom(options.size() + 1);
+            screen.status().setLine(0, "Up/Down to move, Enter to select", A_REVERSE);
+        }, [&](const Event& event) {
+            if (event.type == Event::Mouse) {
+                // Options are drawn from the second line down
+                if (event.mouse.y >= 1 && event.mouse.y <= static_cast<int>(options.size())) {
+                    selected = event.mouse.y - 1;
+                    return false;
+                }
+            } else if (event.type == Event::Key) {
+                if (event.key == KEY_UP) {
+                    selected = (selected - 1 + options.size()) % options.size();
+                } else if (event.key == KEY_DOWN) {
+                    selected = (selected + 1) % options.size();
+                } else if (event.key == 10) { // Enter key
+                    return false;
+                }
             }
-        }
-        mvprintw(1, 1, "Total Submitted Questions: %d", count);
+            return true;
+        });
+        return selected == cancelOption ? -1 : selected;
+    }
+
+    // Prints label on the given body row and reads a line of input after it,
+    // echoed unless hidden. Background work carries on while the user types.
+    // The input starts out as initial, for editing an existing value.
+    string prompt(int row, const string& label, size_t maxLength = 255, bool hidden = false, const string& initial = "") {
+        string input = initial;
+        events.run([&] {
+            string shown = label + (hidden ? "" : input);
+            screen.body().setLine(row, shown);
+            screen.body().placeCursor(row, min(static_cast<int>(shown.size()), screen.body().width() - 1));
+        }, [&](const Event& event) {
+            if (event.type != Event::Key) {
+                return true;
+            }
+            if (event.key == 10 || event.key == KEY_ENTER) {
+                return false;
+            } else if (event.key == KEY_BACKSPACE || event.key == 127 || event.key == 8) {
+                if (!input.empty()) {
+                    input.pop_back();
+                }
+            } else if (event.key >= 32 && event.key < 127 && input.size() < maxLength) {
+                input += static_cast<char>(event.key);
+            }
+            return true;
+        });
+        return input;
     }
 
     void addQuestion() {
-        char questionText[256]; // Initialize a character array with a buffer size
-        char questionNumber[10]; // Initialize a character array for question number
-        clear();
-        
+        int number = 0; // Parsed question number
+        screen.body().clearFrom(0);
+        screen.status().setLine(0, "");
+
         // Prompt for question number
         while (true) {
-            printw("Enter question number (numeric only): ");
-            echo(); // Enable echoing of input characters
-            getstr(questionNumber); // Read input into the buffer
-            noecho(); // Disable echoing again
+            string questionNumber = prompt(0, "Enter question number (numeric only): ", 9);
 
             // Validate that the input is numeric
-            bool isValid = true;
-            for (int i = 0; questionNumber[i] != '\0'; i++) {
-                if (!isdigit(questionNumber[i])) {
-                    isValid = false;
-                    break;
-                }
-            }
-
-            if (isValid) {
+            if (parseQuestionNumber(questionNumber, number)) {
                 break; // Valid input, exit the loop
             } else {
                 showPopup("Invalid input. Please enter a numeric question number. Press any key to try again.");
@@ -120,82 +414,42 @@ private:
         }
 
         // Prompt for question text
-        printw("Enter your question: ");
-        echo(); // Enable echoing of input characters
-        getstr(questionText); // Read input into the buffer
-        noecho(); // Disable echoing again
+        string questionText = prompt(1, "Enter your question: ");
 
         // Validate inputs
-        if (strlen(questionText) == 0) {
+        if (questionText.empty()) {
             showPopup("Question text is required. Press any key to return.");
             return;
         }
 
         // Prompt for status
-        string status;
-        int statusChoice = 0;
         vector<string> statusOptions = {"Submitted", "Under Review", "Not Understood", "Cancel"};
-        while (true) {
-            clear();
-            printw("Set status for the question:\n");
-            for (size_t i = 0; i < statusOptions.size(); ++i) {
-                if (i == statusChoice) {
-                    attron(A_REVERSE); // Highlight selected option
-                }
-                printw("%d. %s\n", i + 1, statusOptions[i].c_str());
-                if (i == statusChoice) {
-                    attroff(A_REVERSE); // Remove highlight
-                }
-            }
-            int ch = getch();
-            if (ch == KEY_UP) {
-                statusChoice = (statusChoice - 1 + statusOptions.size()) % statusOptions.size();
-            } else if (ch == KEY_DOWN) {
-                statusChoice = (statusChoice + 1) % statusOptions.size();
-            } else if (ch == 10) { // Enter key
-                if (statusChoice == 3) { // Cancel option
-                    return; // Exit the function without saving
-                }
-                status = statusOptions[statusChoice];
-                break; // Exit the loop if a valid choice is made
-            } else if (ch == KEY_MOUSE) {
-                MEVENT event;
-                if (getmouse(&event) == OK) {
-                    if (event.y >= 1 && event.y <= 4) { // Check if mouse click is on the status options
-                        statusChoice = event.y - 1; // Set the choice based on the mouse click
-                        if (statusChoice == 3) { // Cancel option
-                            return; // Exit the function without saving
-                        }
-                        status = statusOptions[statusChoice];
-                        break; // Exit the loop if a valid choice is made
-                    }
-                }
-            }
+        int statusChoice = chooseOption("Set status for the question:", statusOptions, 3);
+        if (statusChoice < 0) { // Cancel option
+            return; // Exit the function without saving
         }
+        Status status = static_cast<Status>(statusChoice); // Options are listed in Status order
 
         // Store the question and its status
-        db.addQuestion(string(questionNumber), string(questionText), status); // Store in database
-        questions = db.getQuestions(); // Refresh the questions list to update the count
-        showPopup("Question added: " + string(questionText) + "\nStatus: " + status);
+        if (!questions.add(number, questionText, status)) { // Store in database and cache
+            showPopup("Failed to add question. The number might already exist.");
+            return;
+        }
+        showPopup("Question added: " + questionText + "\nStatus: " + statusName(status));
     }
 
     void deleteAllQuestions() {
-        clear();
-        printw("Are you sure you want to delete all questions? (y/n): ");
-        char confirm = getch();
+        screen.body().setLine(0, "Are you sure you want to delete all questions? (y/n): ");
+        screen.body().clearFrom(1);
+        screen.status().setLine(0, "");
+        int confirm = events.waitForKey();
         if (confirm == 'y' || confirm == 'Y') {
             // Ask for password confirmation
-            clear();
-            char password[256];
-            printw("Enter your password to confirm deletion: ");
-            noecho();  // Disable echoing before getting password
-            getstr(password);
-            noecho();
-            
+            string password = prompt(0, "Enter your password to confirm deletion: ", 255, true);
+
             // Verify password
             if (db.authenticateUser(currentUsername, password)) {
-                db.deleteAllQuestionsFromDB();
-                questions = db.getQuestions();
+                questions.removeAll();
                 showPopup("All questions deleted successfully.");
             } else {
                 showPopup("Incorrect password. Deletion canceled.");
@@ -206,377 +460,591 @@ private:
         }
     }
 
+    // Tells the user there is nothing to show and waits for a key.
+    void showNoQuestions() {
+        screen.body().setLine(0, "No questions available. Press ESC to return to the menu.");
+        screen.body().clearFrom(1);
+        screen.status().setLine(0, "");
+        events.waitForKey();
+    }
+
     void showQuestions() {
-        clear();
-        questions = db.getQuestions(); // Retrieve questions from the database
+        questions.refreshIfChanged(); // Pick up changes made by other connections
         if (questions.empty()) {
-            printw("No questions available. Press ESC to return to the menu.\n");
-            getch();
+            showNoQuestions();
             return;
         }
 
         // Display filter options
-        int filterChoice = 0;
         vector<string> filterOptions = {"Show Submitted", "Show Under Review", "Show Not Understood", "Show All", "Cancel"};
-        while (true) {
-            clear();
-            printw("Filter options:\n");
-            for (size_t i = 0; i < filterOptions.size(); ++i) {
-                if (i == filterChoice) {
-                    attron(A_REVERSE); // Highlight selected option
-                }
-                printw("%d. %s\n", i + 1, filterOptions[i].c_str());
-                if (i == filterChoice) {
-                    attroff(A_REVERSE); // Remove highlight
-                }
-            }
-            int ch = getch();
-            if (ch == KEY_UP) {
-                filterChoice = (filterChoice - 1 + filterOptions.size()) % filterOptions.size();
-            } else if (ch == KEY_DOWN) {
-                filterChoice = (filterChoice + 1) % filterOptions.size();
-            } else if (ch == 10) { // Enter key
-                if (filterChoice == 4) { // Cancel option
-                    return; // Exit the function without saving
-                }
-                // Handle filtering based on the selected option
-                if (filterChoice == 0) {
-                    showFilteredQuestions("Submitted");
-                } else if (filterChoice == 1) {
-                    showFilteredQuestions("Under Review");
-                } else if (filterChoice == 2) {
-                    showFilteredQuestions("Not Understood");
-                } else if (filterChoice == 3) {
-                    showAllQuestions();
-                }
-                break; // Exit the loop after handling the choice
-            } else if (ch == KEY_MOUSE) {
-                MEVENT event;
-                if (getmouse(&event) == OK) {
-                    if (event.y >= 1 && event.y <= 5) { // Check if mouse click is on the filter options
-                        filterChoice = event.y - 1; // Set the choice based on the mouse click
-                        if (filterChoice == 4) { // Cancel option
-                            return; // Exit the function without saving
-                        }
-                        // Handle filtering based on the selected option
-                        if (filterChoice == 0) {
-                            showFilteredQuestions("Submitted");
-                        } else if (filterChoice == 1) {
-                            showFilteredQuestions("Under Review");
-                        } else if (filterChoice == 2) {
-                            showFilteredQuestions("Not Understood");
-                        } else if (filterChoice == 3) {
-                            showAllQuestions();
-                        }
-                        break; // Exit the loop after handling the choice
-                    }
-                }
-            }
+        int filterChoice = chooseOption("Filter options:", filterOptions, 4);
+        // Handle filtering based on the selected option
+        if (filterChoice == 0) {
+            showFilteredQuestions(Status::Submitted);
+        } else if (filterChoice == 1) {
+            showFilteredQuestions(Status::UnderReview);
+        } else if (filterChoice == 2) {
+            showFilteredQuestions(Status::NotUnderstood);
+        } else if (filterChoice == 3) {
+            showAllQuestions();
         }
     }
 
-    void showFilteredQuestions(const string& status) {
-        clear();
-        bool found = false;
-        printw("Questions with status: %s\n", status.c_str()); // Show heading for filtered questions
-        for (const auto& question : questions) {
-            if (question.status == status) {
-                printw("%s: %s\n", question.number.c_str(), question.text.c_str()); // Show question number and text
-                found = true;
-            }
-        }
-        if (!found) {
-            printw("No questions with status: %s. Press ESC to return to the menu.\n", status.c_str());
-        }
-        printw("\nPress ESC to return to the menu...");
-        while (getch() != 27); // Wait for ESC key
+    void showFilteredQuestions(Status status) {
+        QuestionListView view(screen, events, questions, string("Questions with status: ") + statusName(status), status);
+        view.run(); // Pages through the cache, so large lists show instantly
     }
 
     void showAllQuestions() {
-        clear();
-        if (questions.empty()) {
-            printw("No questions available. Press ESC to return to the menu.\n");
-        } else {
-            printw("All Questions:\n"); // Show heading for all questions
-            for (size_t i = 0; i < questions.size(); ++i) {
-                printw("%s: %s | Status: %s\n", questions[i].number.c_str(), questions[i].text.c_str(), questions[i].status.c_str()); // Show question number, text, and status
+        QuestionListView view(screen, events, questions, "All Questions:");
+        view.run(); // Pages through the cache, so large lists show instantly
+    }
+
+    void showQuestionRange(int low, int high) {
+        events.run([&] {
+            Pane& body = screen.body();
+            int row = 0;
+            body.setLine(row++, "Questions " + to_string(low) + "-" + to_string(high) + ":"); // Show heading for the range
+            questions.forEachInRange(low, high, [&](const QuestionView& question) {
+                // Show question number, text, and status
+                body.setLine(row++, to_string(question.number) + ": " + string(question.text) + " | Status: " + statusName(question.status));
+            });
+            if (row == 1) {
+                body.setLine(row++, "No questions in this range.");
             }
-        }
-        printw("\nPress ESC to return to the menu...");
-        while (getch() != 27); // Wait for ESC key
+            body.clearFrom(row);
+            screen.status().setLine(0, "Press ESC to return to the menu...", A_REVERSE);
+        }, [](const Event& event) {
+            return !(event.type == Event::Key && event.key == 27); // Wait for ESC key
+        });
     }
 
     void searchQuestion() {
-        questions = db.getQuestions(); // Ensure questions are loaded before searching
-        clear();
+        questions.refreshIfChanged(); // Ensure questions are current before searching
         if (questions.empty()) {
-            printw("No questions available. Press ESC to return to the menu.\n");
-            getch();
+            showNoQuestions();
             return;
         }
 
-        // Prompt for question number
-        char searchNumber[10]; // Initialize a character array for search input
-        printw("Enter question number to search: ");
-        echo(); // Enable echoing of input characters
-        getstr(searchNumber); // Read input into the buffer
-        noecho(); // Disable echoing again
+        // Prompt for question number, range or title
+        screen.body().clearFrom(1);
+        screen.status().setLine(0, "");
+        string input = prompt(0, "Enter question number, range (e.g. 1000-1500) or title to search: ", 127);
+        if (input.empty()) {
+            showPopup("Invalid input. Please enter a question number or title.");
+            return;
+        }
 
-        // Search for the question
-        bool found = false;
-        Question foundQuestion;
-        for (const auto& question : questions) {
-            if (question.number == searchNumber) {
-                foundQuestion = question; // Store found question
-                found = true;
-                break;
-            }
+        // A range such as "1000-1500" lists every question in it, in either order
+        size_t dash = input.find('-');
+        int low, high;
+        if (dash != string::npos && parseQuestionNumber(input.substr(0, dash), low) &&
+            parseQuestionNumber(input.substr(dash + 1), high)) {
+            showQuestionRange(min(low, high), max(low, high));
+            return;
         }
 
-        if (!found) {
-            printw("No question found with number: %s. Press ESC to return to the menu.\n", searchNumber);
+        // Anything that is not a number is looked up by title, allowing typos
+        int number;
+        if (!parseQuestionNumber(input, number)) {
+            showTitleMatches(input);
+            return;
+        }
+        optional<QuestionView> match = questions.find(number);
+        if (!match) {
+            optional<QuestionView> next = questions.jumpTo(number);
+            if (next) {
+                showPopup("No question found with number: " + input + ". Next question is " + to_string(next->number) + ".");
+            } else {
+                showPopup("No question found with number: " + input + ".");
+            }
         } else {
-            clear();
-            printw("Found Question:\n");
-            printw("Number: %s\nText: %s\nStatus: %s\n", foundQuestion.number.c_str(), foundQuestion.text.c_str(), foundQuestion.status.c_str());
-            printw("\nOptions:\n");
-            vector<string> options = {"Update Question", "Delete Question", "Back to Menu"};
-            int selected = 0;
-
-            while (true) {
-                for (size_t i = 0; i < options.size(); ++i) {
-                    if (i == selected) {
-                        attron(A_REVERSE); // Highlight selected option
-                    }
-                    printw("%d. %s\n", i + 1, options[i].c_str());
-                    if (i == selected) {
-                        attroff(A_REVERSE); // Remove highlight
-                    }
-                }
+            showQuestionActions(ownedCopy(*match));
+        }
+    }
 
-                int ch = getch();
-                if (ch == KEY_UP) {
-                    selected = (selected - 1 + options.size()) % options.size();
-                } else if (ch == KEY_DOWN) {
-                    selected = (selected + 1) % options.size();
-                } else if (ch == 10) { // Enter key
-                    if (selected == 0) {
-                        clear();
-                        printw("Updating Question:\n");
-                        printw("Number: %s\nText: %s\nStatus: %s\n", foundQuestion.number.c_str(), foundQuestion.text.c_str(), foundQuestion.status.c_str());
-                        updateQuestion(foundQuestion.number); // Pass the question number to update
-                        return; // Back to Menu
-                    } else if (selected == 1) {
-                        clear();
-                        printw("Deleting Question:\n");
-                        printw("Number: %s\nText: %s\nStatus: %s\n", foundQuestion.number.c_str(), foundQuestion.text.c_str(), foundQuestion.status.c_str());
-                        deleteQuestion(foundQuestion.number);
-                        return; // Back to Menu
-                    } else {
-                        return; // Back to Menu
-                    }
-                } else if (ch == KEY_MOUSE) {
-                    MEVENT event;
-                    if (getmouse(&event) == OK) {
-                        if (event.y >= 0 && event.y < options.size()) {
-                            selected = event.y; // Set the selected option based on mouse click
-                        }
-                    }
+    // Lists the questions whose titles best match the query, for typed-from-memory
+    // titles such as "lru cach". Enter opens the highlighted question.
+    void showTitleMatches(const string& query) {
+        const size_t limit = 100;
+        auto start = chrono::steady_clock::now();
+        vector<QuestionView> found = questions.searchTitles(query, limit);
+        string timing = formatElapsed(start, "matched");
+        if (found.empty()) {
+            showPopup("No question title matches: " + query);
+            return;
+        }
+        vector<Question> matches; // Copies, since the cache may change while the list is open
+        for (const QuestionView& question : found) {
+            matches.push_back(ownedCopy(question));
+        }
+        char footprint[48];
+        snprintf(footprint, sizeof(footprint), ", index %.1f MiB", questions.titleIndexBytes() / (1024.0 * 1024.0));
+        int selected = 0;
+
+        events.run([&] {
+            TRACK_LATENCY("TUI::render(title matches)");
+            Pane& body = screen.body();
+            body.setLine(0, "Titles matching: " + query);
+            int visible = max(1, body.height() - 1);
+            int first = selected < visible ? 0 : selected - visible + 1; // Keep the selection on screen
+            int row = 1;
+            for (int i = first; i < static_cast<int>(matches.size()) && i < first + visible; ++i) {
+                string line = to_string(matches[i].number) + ": " + matches[i].text + " | Status: " + statusName(matches[i].status);
+                body.setLine(row++, line, i == selected ? A_REVERSE : A_NORMAL);
+            }
+            body.clearFrom(row);
+            screen.status().setLine(0, to_string(matches.size()) + " matches" + timing + footprint + " - Enter to open, ESC to return",
+                                    A_REVERSE);
+        }, [&](const Event& event) {
+            if (event.type != Event::Key) {
+                return true;
+            }
+            if (event.key == 27) { // ESC key
+                return false;
+            } else if (event.key == KEY_UP) {
+                selected = (selected - 1 + matches.size()) % matches.size();
+            } else if (event.key == KEY_DOWN) {
+                selected = (selected + 1) % matches.size();
+            } else if (event.key == 10) { // Enter key
+                showQuestionActions(matches[selected]);
+                return false; // Back to Menu
+            }
+            return true;
+        });
+    }
+
+    // Live search: results refresh as the user types. Extending the query narrows
+    // the previous results in memory; anything else waits for a short pause in
+    // typing and then queries the FTS index, abandoning the query if another key
+    // arrives first.
+    void searchText() {
+        const int debounceMs = 15; // Pause in typing before hitting the index
+        IncrementalSearch search(questions, 100); // Sees writes still queued on the worker
+        string query;
+        int debounce = -1; // Timer for a query changed but not searched yet
+        int selected = 0;
+        string timing;
+
+        events.run([&] {
+            TRACK_LATENCY("TUI::render(search)");
+            const vector<Question>& results = search.results();
+            Pane& body = screen.body();
+            body.setLine(0, "Search: " + query);
+            int visible = max(1, body.height() - 1);
+            int first = selected < visible ? 0 : selected - visible + 1; // Keep the selection on screen
+            int row = 1;
+            for (int i = first; i < static_cast<int>(results.size()) && i < first + visible; ++i) {
+                string line = to_string(results[i].number) + ": " + results[i].text + " | Status: " + statusName(results[i].status);
+                body.setLine(row++, line, i == selected ? A_REVERSE : A_NORMAL); // Highlight selected result
+            }
+            body.clearFrom(row);
+            screen.status().setLine(0, to_string(results.size()) + " results" + timing + " - Enter to open, ESC to return", A_REVERSE);
+            body.placeCursor(0, 8 + query.size()); // Leave the cursor at the end of the query
+        }, [&](const Event& event) {
+            const vector<Question>& results = search.results();
+            if (event.type == Event::Timer && event.timer == debounce) { // Typing paused: run the deferred search
+                auto start = chrono::steady_clock::now();
+                bool done = search.search(query, [] {
+                    pollfd input{STDIN_FILENO, POLLIN, 0};
+                    return poll(&input, 1, 0) > 0; // A newer keystroke makes this search stale
+                });
+                if (done) {
+                    debounce = -1;
+                    selected = 0;
+                    timing = formatElapsed(start, "searched");
+                } else {
+                    debounce = events.after(debounceMs); // Try again once typing pauses
                 }
-                clear(); // Clear the screen for the next iteration
+                return true;
             }
-        }
+            if (event.type != Event::Key) {
+                return true;
+            }
+            int ch = event.key;
+            if (ch == 27) { // ESC key
+                events.cancel(debounce);
+                return false;
+            } else if (ch == KEY_UP && !results.empty()) {
+                selected = (selected - 1 + results.size()) % results.size();
+                return true;
+            } else if (ch == KEY_DOWN && !results.empty()) {
+                selected = (selected + 1) % results.size();
+                return true;
+            } else if (ch == 10) { // Enter key
+                if (debounce < 0 && !results.empty()) {
+                    showQuestionActions(results[selected]);
+                    return false; // Back to Menu
+                }
+                return true;
+            } else if (ch == KEY_BACKSPACE || ch == 127 || ch == 8) {
+                if (query.empty()) {
+                    return true;
+                }
+                query.pop_back();
+            } else if (ch >= 32 && ch < 127 && query.size() < 127) {
+                query += static_cast<char>(ch);
+            } else {
+                return true;
+            }
+
+            // The query changed: answer from earlier results if possible
+            events.cancel(debounce);
+            auto start = chrono::steady_clock::now();
+            if (search.reuse(query)) {
+                debounce = -1;
+                selected = 0;
+                timing = formatElapsed(start, "reused");
+            } else {
+                debounce = events.after(debounceMs);
+            }
+            return true;
+        });
     }
 
-    void updateQuestion(const string& questionNumber) {
-        string newStatus;
-        clear();
-        printw("Updating Question:\n");
-        // Retrieve the question from the database
-        for (const auto& question : questions) {
-            if (question.number == questionNumber) {
-                printw("Current Text: %s\n", question.text.c_str());
+    // Live tag filter: the query is evaluated over the cache's tag and status
+    // bitmaps on every keystroke, and again each second to pick up changes
+    // from elsewhere. Lists the first matches in number order; an invalid
+    // query leaves the last valid one's matches up under its error.
+    void filterQuestions() {
+        const size_t limit = 1000;
+        string query;
+        Bitmap matches;
+        vector<int> numbers; // The first limit matches
+        string error;
+        string timing;
+        int selected = 0;
+        auto evaluate = [&] {
+            auto start = chrono::steady_clock::now();
+            Bitmap result;
+            if (!questions.filter(query, result, error)) {
+                return; // Keep the last results while a word is half typed
+            }
+            timing = formatElapsed(start, "filtered");
+            error.clear();
+            matches = std::move(result);
+            numbers.clear();
+            matches.forEach([&](uint32_t number) {
+                numbers.push_back(static_cast<int>(number));
+                return numbers.size() < limit;
+            });
+            selected = min(selected, max(0, static_cast<int>(numbers.size()) - 1));
+        };
+        evaluate();
+        int ticker = events.every(refreshIntervalMs, nullptr);
 
-                // Prompt for new status
-        int statusChoice = 0;
-        vector<string> statusOptions = {"Submitted", "Under Review", "Not Understood", "Cancel"};
-        while (true) {
-            clear();
-            printw("Set new status for the question:\n");
-            for (size_t i = 0; i < statusOptions.size(); ++i) {
-                if (i == statusChoice) {
-                    attron(A_REVERSE); // Highlight selected option
+        events.run([&] {
+            TRACK_LATENCY("TUI::render(filter)");
+            Pane& body = screen.body();
+            body.setLine(0, "Filter: " + query);
+            vector<pair<string, size_t>> tags = questions.tagCounts();
+            string available = tags.empty() ? "No tags yet; add them from a question's details" : "Tags:";
+            for (const auto& [tag, count] : tags) {
+                available += " " + tag + " (" + to_string(count) + ")";
+            }
+            body.setLine(1, available, A_DIM);
+            body.setLine(2, error.empty() ? "" : "Error: " + error);
+            int visible = max(1, body.height() - 3);
+            int first = selected < visible ? 0 : selected - visible + 1; // Keep the selection on screen
+            int row = 3;
+            for (int i = first; i < static_cast<int>(numbers.size()) && i < first + visible; ++i) {
+                optional<QuestionView> question = questions.find(numbers[i]);
+                if (!question) {
+                    continue; // Deleted since the last evaluation
                 }
-                printw("%d. %s\n", i + 1, statusOptions[i].c_str());
-                if (i == statusChoice) {
-                    attroff(A_REVERSE); // Remove highlight
+                string line = to_string(question->number) + ": " + string(question->text) + " | Status: " +
+                              statusName(question->status);
+                vector<string> tagged = questions.tagsOf(question->number);
+                if (!tagged.empty()) {
+                    line += " | Tags: " + joinTags(tagged, ", ");
                 }
+                body.setLine(row++, line, i == selected ? A_REVERSE : A_NORMAL);
+            }
+            body.clearFrom(row);
+            string count = to_string(matches.cardinality()) + " matches" + timing;
+            if (numbers.size() == limit) {
+                count += ", first " + to_string(limit) + " listed";
+            }
+            screen.status().setLine(0, count + " - e.g. dp and graph and not submitted; Enter to open, ESC to return",
+                                    A_REVERSE);
+            body.placeCursor(0, 8 + query.size()); // Leave the cursor at the end of the query
+        }, [&](const Event& event) {
+            if (event.type == Event::Timer && event.timer == ticker) {
+                evaluate(); // The cache may have changed underneath
+                return true;
             }
-            int ch = getch();
-            if (ch == KEY_UP) {
-                statusChoice = (statusChoice - 1 + statusOptions.size()) % statusOptions.size();
-            } else if (ch == KEY_DOWN) {
-                statusChoice = (statusChoice + 1) % statusOptions.size();
+            if (event.type != Event::Key) {
+                return true;
+            }
+            int ch = event.key;
+            if (ch == 27) { // ESC key
+                return false;
+            } else if (ch == KEY_UP && !numbers.empty()) {
+                selected = (selected - 1 + numbers.size()) % numbers.size();
+                return true;
+            } else if (ch == KEY_DOWN && !numbers.empty()) {
+                selected = (selected + 1) % numbers.size();
+                return true;
             } else if (ch == 10) { // Enter key
-                if (statusChoice == 3) { // Cancel option
-                    return; // Exit the function without saving
+                if (!numbers.empty()) {
+                    if (optional<QuestionView> question = questions.find(numbers[selected])) {
+                        showQuestionActions(ownedCopy(*question));
+                        evaluate(); // Its status or tags may have changed
+                    }
+                }
+                return true;
+            } else if (ch == KEY_BACKSPACE || ch == 127 || ch == 8) {
+                if (query.empty()) {
+                    return true;
                 }
-                newStatus = statusOptions[statusChoice];
-                break; // Exit the loop if a valid choice is made
+                query.pop_back();
+            } else if (ch >= 32 && ch < 127 && query.size() < 127) {
+                query += static_cast<char>(ch);
+            } else {
+                return true;
             }
+            selected = 0;
+            evaluate();
+            return true;
+        });
+        events.cancel(ticker);
+    }
+
+    static string formatElapsed(chrono::steady_clock::time_point start, const char* how) {
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        char buffer[48];
+        snprintf(buffer, sizeof(buffer), " (%s in %.2f ms)", how, ms);
+        return buffer;
+    }
+
+    // Shows one question with options to update or delete it.
+    void showQuestionActions(const Question& question) {
+        Question foundQuestion = question; // Copy, since update/delete change the cache
+        vector<string> options = {"Update Question", "Edit Tags", "Delete Question", "Back to Menu"};
+        int selected = 0;
+
+        events.run([&] {
+            Pane& body = screen.body();
+            body.setLine(0, "Found Question:");
+            body.setLine(1, "Number: " + to_string(foundQuestion.number));
+            body.setLine(2, "Text: " + foundQuestion.text);
+            body.setLine(3, string("Status: ") + statusName(foundQuestion.status));
+            body.setLine(4, "Tags: " + joinTags(questions.tagsOf(foundQuestion.number), ", "));
+            body.setLine(5, "");
+            body.setLine(6, "Options:");
+            screen.drawOptions(7, options, selected, 0, true);
+            body.clearFrom(7 + options.size());
+            screen.status().setLine(0, "Up/Down to move, Enter to select", A_REVERSE);
+        }, [&](const Event& event) {
+            if (event.type == Event::Mouse) {
+                // A click only highlights, since Delete has no confirmation
+                int row = event.mouse.y - 7;
+                if (row >= 0 && row < static_cast<int>(options.size())) {
+                    selected = row;
+                }
+                return true;
+            }
+            if (event.type != Event::Key) {
+                return true;
+            }
+            if (event.key == KEY_UP) {
+                selected = (selected - 1 + options.size()) % options.size();
+            } else if (event.key == KEY_DOWN) {
+                selected = (selected + 1) % options.size();
+            } else if (event.key == 10) { // Enter key
+                if (selected == 0) {
+                    updateQuestion(foundQuestion.number); // Pass the question number to update
+                } else if (selected == 1) {
+                    editTags(foundQuestion.number);
+                } else if (selected == 2) {
+                    deleteQuestion(foundQuestion.number);
+                }
+                return false; // Back to Menu
+            }
+            return true;
+        });
+    }
+
+    void updateQuestion(int questionNumber) {
+        // Make sure the question still exists in the cache
+        if (!questions.find(questionNumber)) {
+            showPopup("Question not found.");
+            return;
         }
 
-        if (!newStatus.empty()) {
-            db.updateQuestionInDB(questionNumber, newStatus); // Update in database
+        // Prompt for new status
+        vector<string> statusOptions = {"Submitted", "Under Review", "Not Understood", "Cancel"};
+        int statusChoice = chooseOption("Set new status for the question:", statusOptions, 3);
+        if (statusChoice < 0) { // Cancel option
+            return; // Exit the function without saving
         }
+        Status newStatus = static_cast<Status>(statusChoice); // Options are listed in Status order
 
-        showPopup("Question status updated to: " + newStatus);
-        return; // Exit after updating
-            }
+        if (!questions.updateStatus(questionNumber, newStatus)) { // Update in database and cache
+            showPopup("Failed to update question status.");
+            return;
+        }
+
+        showPopup(string("Question status updated to: ") + statusName(newStatus));
+    }
+
+    // Replaces the question's tags with a list typed over the current one.
+    void editTags(int questionNumber) {
+        if (!questions.find(questionNumber)) {
+            showPopup("Question not found.");
+            return;
+        }
+        screen.body().clearFrom(0);
+        screen.body().setLine(1, "Separate tags with spaces or commas; clear the line to remove them all.");
+        screen.status().setLine(0, "Enter to save", A_REVERSE);
+        string input = prompt(0, "Tags: ", 255, false, joinTags(questions.tagsOf(questionNumber), " "));
+        vector<string> tags;
+        string invalid;
+        if (!parseTagList(input, tags, invalid)) {
+            showPopup("Invalid tag: " + invalid + ". Use letters, digits and -_+#. and not a status name.");
+            return;
+        }
+        if (!questions.setTags(questionNumber, tags)) {
+            showPopup("Failed to update tags.");
+            return;
         }
-        showPopup("Question not found.");
+        showPopup(tags.empty() ? "Tags removed." : "Tags set to: " + joinTags(tags, ", "));
     }
 
-    void deleteQuestion(const string& questionNumber) {
-        db.deleteQuestionFromDB(questionNumber); // Delete from database
+    static string joinTags(const vector<string>& tags, const char* separator) {
+        string joined;
+        for (const string& tag : tags) {
+            joined += (joined.empty() ? "" : separator) + tag;
+        }
+        return joined;
+    }
+
+    void deleteQuestion(int questionNumber) {
+        if (!questions.remove(questionNumber)) { // Delete from database and cache
+            showPopup("Failed to delete question.");
+            return;
+        }
         showPopup("Question deleted successfully.");
     }
 
     bool handleAuthentication() {
-        initscr(); // Initialize ncurses for authentication screen
-        cbreak();
-        noecho();
-        keypad(stdscr, TRUE);
-
         int choice = 0;
         vector<string> authOptions = {"Login", "Create User"};
-        
-        while (true) {
-            clear();
-            printw("Authentication\n\n");
-            printMenu(authOptions, choice);
-            
-            int ch = getch();
-            if (ch == KEY_UP) {
+
+        bool authenticated = false;
+        events.run([&] {
+            screen.body().setLine(0, "Authentication");
+            screen.drawOptions(1, authOptions, choice, 1);
+            screen.body().clearFrom(authOptions.size() + 1);
+            screen.status().setLine(0, "Up/Down to move, Enter to select", A_REVERSE);
+        }, [&](const Event& event) {
+            if (event.type != Event::Key) {
+                return true;
+            }
+            if (event.key == KEY_UP) {
                 choice = (choice - 1 + authOptions.size()) % authOptions.size();
-            } else if (ch == KEY_DOWN) {
+            } else if (event.key == KEY_DOWN) {
                 choice = (choice + 1) % authOptions.size();
-            } else if (ch == 10) { // Enter key
+            } else if (event.key == 10) { // Enter key
                 if (choice == 0) {
                     // Login
-                    return handleLogin();
+                    authenticated = handleLogin();
+                    return false;
                 } else if (choice == 1) {
                     // Create User
                     if (handleUserCreation()) {
-                        return true;
+                        authenticated = true;
+                        return false;
                     }
                 }
             }
-        }
+            return true;
+        });
+        return authenticated;
     }
 
     bool handleLogin() {
         // Login loop
         while (true) {
-            clear();
-            printw("Login\n\n");
-            
-            char username[256];
-            char password[256];
-            
-            // Get username
-            printw("Username: ");
-            echo();
-            getstr(username);
-            noecho();
-            
-            // Get password
-            printw("Password: ");
-            noecho();  // Disable echoing before getting password
-            getstr(password);
-            noecho();
-            
-            // Authenticate
-            if (db.authenticateUser(username, password)) {
+            screen.body().setLine(0, "Login");
+            screen.body().clearFrom(1);
+            screen.status().setLine(0, "");
+
+            string username = prompt(2, "Username: ");
+            string password = prompt(3, "Password: ", 255, true); // Not echoed
+
+            // Authenticate; from here on db only sees this user's questions
+            if (db.signIn(username, password)) {
                 currentUsername = username; // Store the logged-in username
                 showPopup("Login successful!");
                 return true;
             }
-            
+
             showPopup("Invalid username or password. Try again.");
         }
     }
 
     bool handleUserCreation() {
-        clear();
-        printw("Create New User\n\n");
-        
-        char username[256];
-        char password[256];
-        char confirmPassword[256];
-        
-        // Get username
-        printw("Enter username: ");
-        echo();
-        getstr(username);
-        noecho();
-        
-            // Get password
-            printw("Enter password: ");
-            noecho();  // Disable echoing before getting password
-            getstr(password);
-            noecho();
-            
-            // Confirm password
-            printw("Confirm password: ");
-            noecho();  // Disable echoing before getting confirmation
-            getstr(confirmPassword);
-            noecho();
-
-        
+        screen.body().setLine(0, "Create New User");
+        screen.body().clearFrom(1);
+        screen.status().setLine(0, "");
+
+        string username = prompt(2, "Enter username: ");
+        string password = prompt(3, "Enter password: ", 255, true); // Not echoed
+        string confirmPassword = prompt(4, "Confirm password: ", 255, true);
+
         // Validate inputs
-        if (strlen(username) == 0 || strlen(password) == 0) {
+        if (username.empty() || password.empty()) {
             showPopup("Username and password are required.");
             return false;
         }
-        
-        if (strcmp(password, confirmPassword) != 0) {
+
+        if (password != confirmPassword) {
             showPopup("Passwords do not match.");
             return false;
         }
-        
+
         // Create user
-        if (!db.createUser(username, password)) {
+        if (!db.createUser(username, password) || !db.signIn(username, password)) {
             showPopup("Failed to create user. The username might already exist.");
             return false;
         }
-        
+        currentUsername = username;
+
         showPopup("User created successfully!");
         return true;
     }
 
     void showPopup(const string& message) {
-        clear();
-        mvprintw(1, 1, "%s", message.c_str()); // Display at fixed vertical position
-        printw("\nPress any key to continue...");
-        getch();
+        screen.showPopup(message); // Drawn over the current screen, which is uncovered afterwards
+        events.waitForKey();
+        screen.hidePopup();
     }
+};
 
-    void printMenu(const vector<string>& options, int selected) {
-        for (size_t i = 0; i < options.size(); ++i) {
-            if (i == selected) {
-                attron(A_REVERSE); // Highlight selected option
-            }
-            mvprintw(i + 1, 1, options[i].c_str());
-            if (i == selected) {
-                attroff(A_REVERSE); // Remove highlight
-            }
+int main(int argc, char** argv) {
+    // The stats report is written on every exit, to latency-stats.txt next to
+    // questions.db unless TRACKER_STATS_DUMP=FILE or --stats-dump[=FILE] (stderr
+    // by default) says otherwise.
+    optional<string> statsDump = "latency-stats.txt";
+    if (const char* dumpPath = getenv("TRACKER_STATS_DUMP")) {
+        statsDump = dumpPath;
+    }
+    vector<char*> args;
+    for (int i = 0; i < argc; ++i) {
+        if (i > 0 && strcmp(argv[i], "--stats-dump") == 0) {
+            statsDump = "";
+        } else if (i > 0 && strncmp(argv[i], "--stats-dump=", 13) == 0) {
+            statsDump = argv[i] + 13;
+        } else {
+            args.push_back(argv[i]);
         }
     }
-};
-
-int main() {
+    if (args.size() >= 2) {
+        return runCli("questions.db", static_cast<int>(args.size()), args.data(), statsDump); // Headless mode, no ncurses
+    }
     TUI tui;
     tui.run();
+    writeStatsDump(*statsDump, tui.statsReport());
     return 0;
 }